@@ -40,257 +40,1358 @@
 #include "Si4735.h"
 #include <string.h>
 
+//No RDS in AM bands
+#ifndef Si47xx_AM_ONLY
+
 /******************************************************************************
 *   RDS/RBDS                                                                  *
 ******************************************************************************/
 
 // Examines given character.  If printable ASCII character, the character
-// is returned.  If not printable, a space is returned.
+// is returned.  If not printable, a space is returned.  With Si47xx_RDS_UTF8, chars of
+// the RDS character set above 127 are printable too.  See RDSToUTF8().
 // ***** PRIVATE *****
 static char make_printable(char ch){
+ #ifdef Si47xx_RDS_UTF8
+   //Replace control char with space
+   if((byte)ch<32 || ch==127) ch=' ';
+ #else
    //Replace non-ASCII char with space
    if(ch<32 || 126<ch) ch=' ';
+ #endif
    return ch;
 }
 
+#if defined(Si47xx_RDS_UTF8) || defined(Si47xx_RDS_ERT)
+// Saves Unicode char code as UTF-8.  Returns number of bytes saved: 1, 2, or 3.
+// ***** PRIVATE *****
+static byte encode_utf8(char *utf8, word code){
+   if(code<0x80){
+      utf8[0]=code;
+      return 1;
+   }
+   if(code<0x800){
+      utf8[0]=0xC0 | code>>6;
+      utf8[1]=0x80 | (code & 0x3F);
+      return 2;
+   }
+   utf8[0]=0xE0 | code>>12;
+   utf8[1]=0x80 | ((code>>6) & 0x3F);
+   utf8[2]=0x80 | (code & 0x3F);
+   return 3;
+}
+
+// Number of bytes that fit in size without splitting a UTF-8 char.
+// ***** PRIVATE *****
+static byte utf8_fit(const char *utf8, byte length, byte size){
+   if(length<=size) return length;
+   //Back up over continuation bytes (10xxxxxx) to start of split char
+   while(size && (utf8[size] & 0xC0)==0x80) size--;
+   return size;
+}
+#endif
+
+#ifdef Si47xx_RDS_UTF8
+// Unicode of RDS chars 0x80-0xFF (EN 50067 Annex E, code table G0).  0xFF is unused.
+static const word RDS_G0_unicode[128] PROGMEM = {
+   0x00E1, 0x00E0, 0x00E9, 0x00E8, 0x00ED, 0x00EC, 0x00F3, 0x00F2,  //0x80
+   0x00FA, 0x00F9, 0x00D1, 0x00C7, 0x015E, 0x00DF, 0x00A1, 0x0132,
+   0x00E2, 0x00E4, 0x00EA, 0x00EB, 0x00EE, 0x00EF, 0x00F4, 0x00F6,  //0x90
+   0x00FB, 0x00FC, 0x00F1, 0x00E7, 0x015F, 0x01E7, 0x0131, 0x0133,
+   0x00AA, 0x03B1, 0x00A9, 0x2030, 0x01E6, 0x011B, 0x0148, 0x0151,  //0xA0
+   0x03C0, 0x20AC, 0x00A3, 0x0024, 0x2190, 0x2191, 0x2192, 0x2193,
+   0x00BA, 0x00B9, 0x00B2, 0x00B3, 0x00B1, 0x0130, 0x0144, 0x0171,  //0xB0
+   0x00B5, 0x00BF, 0x00F7, 0x00B0, 0x00BC, 0x00BD, 0x00BE, 0x00A7,
+   0x00C1, 0x00C0, 0x00C9, 0x00C8, 0x00CD, 0x00CC, 0x00D3, 0x00D2,  //0xC0
+   0x00DA, 0x00D9, 0x0158, 0x010C, 0x0160, 0x017D, 0x00D0, 0x013F,
+   0x00C2, 0x00C4, 0x00CA, 0x00CB, 0x00CE, 0x00CF, 0x00D4, 0x00D6,  //0xD0
+   0x00DB, 0x00DC, 0x0159, 0x010D, 0x0161, 0x017E, 0x0111, 0x0140,
+   0x00C3, 0x00C5, 0x00C6, 0x0152, 0x0177, 0x00DD, 0x00D5, 0x00D8,  //0xE0
+   0x00DE, 0x014A, 0x0154, 0x0106, 0x015A, 0x0179, 0x0166, 0x00F0,
+   0x00E3, 0x00E5, 0x00E6, 0x0153, 0x0175, 0x00FD, 0x00F5, 0x00F8,  //0xF0
+   0x00FE, 0x014B, 0x0155, 0x0107, 0x015B, 0x017A, 0x0167, 0x0020
+};
+
+// Saves RDS char as UTF-8.  Returns number of bytes saved: 1, 2, or 3.
+// ***** PRIVATE *****
+static byte rds_char_utf8(char *utf8, char ch){
+   if(!(ch & 0x80)){
+      //ASCII, except RDS has no DEL
+      utf8[0] = (ch<32 || ch==127) ? ' ' : ch;
+      return 1;
+   }
+   return encode_utf8(utf8, pgm_read_word(&RDS_G0_unicode[ch & 0x7F]));
+}
+
+byte Si4735::RDSToUTF8(char *utf8, byte size, const char *text, byte length){
+   byte n=0;
+   char buffer[3];
+   if(!size) return 0;
+   for(byte i=0; i<length && text[i]; i++){
+      byte bytes = rds_char_utf8(buffer, text[i]);
+      if(n+bytes>size-1) break;
+      memcpy(&utf8[n], buffer, bytes);
+      n+=bytes;
+   }
+   utf8[n]='\0';
+   return n;
+}
+
+// Segments are translated into place.  _utf8_end[] gives where each segment ends in the
+// buffer, so a segment that changes length moves only the text after it.
+bool Si4735::getRadioTextUTF8(char *utf8, byte size){
+   if(!size) return false;
+   byte segment_size = (rds.groupA & 1U<<2) ? 4 : 2;
+   byte length = rds.radioTextLen;
+   if(length>16*segment_size) length=16*segment_size;
+   if(utf8!=_utf8_text || size!=_utf8_size || segment_size!=_utf8_segment ||
+    length!=_utf8_length){
+      //Start over
+      _utf8_text=utf8;
+      _utf8_size=size;
+      _utf8_segment=segment_size;
+      _utf8_length=length;
+      _utf8_dirty=0xFFFF;
+      memset(_utf8_end, 0, sizeof(_utf8_end));
+      utf8[0]='\0';
+   }
+   byte segments = (length+segment_size-1)/segment_size;
+   //Segments past end of message are not shown
+   if(segments<16) _utf8_dirty &= (1U<<segments)-1;
+   if(!_utf8_dirty) return false;
+
+   byte used = segments ? _utf8_end[segments-1] : 0;  //Length of UTF-8 string
+   word dirty=_utf8_dirty;
+   bool changed=false;
+   for(byte segment=0; segment<segments; segment++){
+      if(!(dirty & 1U<<segment)) continue;
+      //Translate segment, cut at end of message
+      char buffer[4*3];
+      byte start = segment*segment_size;
+      byte chars = length-start<segment_size ? length-start : segment_size;
+      byte bytes=0;
+      for(byte i=0; i<chars; i++){
+         bytes += rds_char_utf8(&buffer[bytes], rds.radioText[start+i]);
+      }
+      //Cut what does not fit.  Part that did not fit is tried again next call.
+      byte begin = segment ? _utf8_end[segment-1] : 0;
+      byte old_bytes = _utf8_end[segment]-begin;
+      byte room = size-1-(used-old_bytes);
+      byte fit = utf8_fit(buffer, bytes, room<sizeof(buffer) ? room : sizeof(buffer));
+      if(fit==bytes) dirty &= ~(1U<<segment);
+      //Move rest of text if segment length changed
+      if(fit!=old_bytes){
+         memmove(&utf8[begin+fit], &utf8[begin+old_bytes], used-begin-old_bytes);
+         for(byte i=segment; i<segments; i++) _utf8_end[i] += fit-old_bytes;
+         used += fit-old_bytes;
+         changed=true;
+      }else if(memcmp(&utf8[begin], buffer, fit)!=0){
+         changed=true;
+      }
+      memcpy(&utf8[begin], buffer, fit);
+   }
+   utf8[used]='\0';
+   _utf8_dirty=dirty;
+   return changed;
+}
+#endif
+
+#ifdef Si47xx_RDS_ERT
+byte Si4735::getEnhancedRadioTextUTF8(char *utf8, byte size){
+   byte n=0;
+   if(!size) return 0;
+   if(ert.utf8){
+      //Copy as is.  Bytes not yet received become spaces.
+      for(byte i=0; i<ert.length; i++){
+         if(n==size-1){
+            //Out of room.  Drop char that was split.
+            if((ert.text[i] & 0xC0)==0x80){
+               while(n && (utf8[n-1] & 0xC0)==0x80) n--;
+               if(n) n--;
+            }
+            break;
+         }
+         utf8[n++] = ert.text[i] ? ert.text[i] : ' ';
+      }
+   }else{
+      //UCS-2, high byte first
+      char buffer[3];
+      for(byte i=0; i+1<ert.length; i+=2){
+         word code = MAKE_WORD(ert.text[i], ert.text[i+1]);
+         byte bytes = encode_utf8(buffer, code ? code : ' ');
+         if(n+bytes>size-1) break;
+         memcpy(&utf8[n], buffer, bytes);
+         n+=bytes;
+      }
+   }
+   utf8[n]='\0';
+   return n;
+}
+#endif
+
+// Blocks of an RDS group for rds_weight()
+enum {
+   BLOCK_A=FIELD_RDS_STATUS_RESP12_BLOCK_A,
+   BLOCK_B=FIELD_RDS_STATUS_RESP12_BLOCK_B,
+   BLOCK_C=FIELD_RDS_STATUS_RESP12_BLOCK_C,
+   BLOCK_D=FIELD_RDS_STATUS_RESP12_BLOCK_D
+};
+
 // Poll RDS info from radio and saves in class object.  Also clears RDS interrupt.
 // Returns true if new info found.  If not FM mode, it returns false.
-// TODO: Add RT+, eRT, and maybe TMC
 bool Si4735::getRDS(){
-   byte response[13];  //Returned RDS info
-   //Indices for group data in response[]
-   enum {
-      PI_H=4,  //Also "Block A"
-      PI_L,
-      Block_B_H,
-      Block_B_L,
-      Block_C_H,
-      Block_C_L,
-      Block_D_H,
-      Block_D_L
-   };
-   byte segment;  //Current segment
    bool new_info=false;  //Return value - true if new RDS info has been collected
 
    //Check for FM mode
    if(_mode!=FM) return false;
+ #ifdef Si47xx_RDS_BUFFER
+   //Drain radio's FIFO, then decode.  Repeat if buffer was too small.
+   bool full;
+   do{
+      readRDS();
+      full = _rds_count==Si47xx_RDS_BUFFER;
+      if(decodeRDS()) new_info=true;
+   }while(full);
+ #else
+   byte response[RDS_STATUS_LENGTH];  //Returned RDS info
    //Clear local RDS interrupt
    clearInterrupts(RDS_MASK);
    //Read in all pending RDS groups (packets)
    while(1){
       //Ask for next RDS group and clear RDS interrupt
-      static const byte PROGMEM FM_RDS_STATUS[]={CMD_FM_RDS_STATUS, RDS_STATUS_ARG1_CLEAR_INT};
-      sendCommand_P(FM_RDS_STATUS, sizeof(FM_RDS_STATUS));
-      getResponse(response, sizeof(response));
-
-      //Check for RDS signal
-      rds.RDSSignal = response[2] & FIELD_RDS_STATUS_RESP2_SYNC;
-      //Get number of RDS groups (packets) available
-      byte num_groups=response[3];
+      byte num_groups=read_rds_group(response);
       //Stop if nothing returned
       if(!num_groups) break;
+      if(decode_group(response)) new_info=true;
+      //Stop if that was the last group.  Saves a command.
+      if(num_groups==1) break;
+   }
+ #endif
+   return new_info;
+}
+
+#ifdef Si47xx_RDS_BUFFER
+// Copy all RDS groups in radio's FIFO to _rds_buffer[].
+byte Si4735::readRDS(){
+   byte response[RDS_STATUS_LENGTH];  //Returned RDS info
+   byte count=0;  //Groups read
+
+   //Check for FM mode
+   if(_mode!=FM) return 0;
+   //Clear local RDS interrupt
+   clearInterrupts(RDS_MASK);
+   while(_rds_count<Si47xx_RDS_BUFFER){
+      byte num_groups=read_rds_group(response);
+      if(!num_groups) break;
+      //Save raw group at end of ring
+      byte i=_rds_head+_rds_count;
+      if(i>=Si47xx_RDS_BUFFER) i-=Si47xx_RDS_BUFFER;
+      memcpy(_rds_buffer[i], &response[RDS_BLOCK_A_H], RDS_GROUP_LENGTH);
+      ++_rds_count;
+      ++count;
+      if(num_groups==1) break;
+   }
+   return count;
+}
 
-      /* Because PI is resent in every packet's Block A, we told the radio its OK to
-       * give us packets with a corrupted Block A.
-       */
-      //Check if PI received is valid
-      if((response[12] & FIELD_RDS_STATUS_RESP12_BLOCK_A) != RDS_STATUS_RESP12_BLOCK_A_UNCORRECTABLE){
-         //Get PI code
-         rds.programId = MAKE_WORD(response[PI_H], response[PI_L]);
+// Decode groups in _rds_buffer[].
+bool Si4735::decodeRDS(){
+   byte group[RDS_STATUS_LENGTH];  //Group in FM_RDS_STATUS response format
+   bool new_info=false;
+   while(_rds_count){
+      memcpy(&group[RDS_BLOCK_A_H], _rds_buffer[_rds_head], RDS_GROUP_LENGTH);
+      if(++_rds_head>=Si47xx_RDS_BUFFER) _rds_head=0;
+      --_rds_count;
+      if(decode_group(group)) new_info=true;
+   }
+   return new_info;
+}
+#endif
+
+#ifdef Si47xx_RDS_CAPTURE
+void Si4735::setRDSCapture(RDSCaptureSink sink){
+   _rds_sink=sink;
+}
+
+bool Si4735::replayRDS(const byte *record){
+   //Rebuild FM_RDS_STATUS response
+   byte response[RDS_STATUS_LENGTH];
+   memcpy(&response[RDS_BLOCK_A_H], &record[RDS_RECORD_BLOCKS], RDS_GROUP_LENGTH);
+   rds.RDSSignal = record[RDS_RECORD_FLAGS] & RDS_RECORD_SYNC;
+   return decode_group(response);
+}
+#endif
+
+void Si4735::setRDSBatch(byte groups){
+   if(groups>RDS_FIFO_SIZE) groups=RDS_FIFO_SIZE;
+   //0 and 1 both interrupt on every group.  0 is the radio's default.
+   _rds_batch = groups>1 ? groups : 0;
+   if(_mode==FM) setProperty(PROP_FM_RDS_INT_FIFO_COUNT, _rds_batch);
+}
+
+// ***** PRIVATE *****
+byte Si4735::read_rds_group(byte *response){
+   //Ask for next RDS group and clear RDS interrupt
+   static const byte PROGMEM FM_RDS_STATUS[]={CMD_FM_RDS_STATUS, RDS_STATUS_ARG1_CLEAR_INT};
+   sendCommand_P(FM_RDS_STATUS, sizeof(FM_RDS_STATUS));
+   getResponse(response, RDS_STATUS_LENGTH);
+
+   //Check for RDS signal
+   rds.RDSSignal = response[2] & FIELD_RDS_STATUS_RESP2_SYNC;
+ #ifdef Si47xx_RDS_CAPTURE
+   if(_rds_sink && response[3]){
+      //Build capture record from response
+      byte record[RDS_RECORD_LENGTH];
+      unsigned long time=millis();
+      for(byte i=0; i<4; i++){
+         record[RDS_RECORD_TIME+i] = time;
+         time >>= 8;
       }
-      //Get PTY code
-      rds.programType = ((response[Block_B_H] & 0b00000011) << 3U) | (response[Block_B_L] >> 5U);
-      //Get Traffic Program bit
-      rds.trafficProgram = bool(response[Block_B_H] & 0b00000100);
-
-      //Get group type (0-15)
-      byte type = response[Block_B_H]>>4U;
-      //Get group version (0=A, 1=B)
-      bool version = response[Block_B_H] & 0b00001000;
-
-      //Save which group type and version was received
-      if(version){
-         rds.groupB |= 1U<<type;
-      }else{
-         rds.groupA |= 1U<<type;
+      memcpy(&record[RDS_RECORD_BLOCKS], &response[RDS_BLOCK_A_H], RDS_GROUP_LENGTH);
+      record[RDS_RECORD_FLAGS] = (rds.RDSSignal ? RDS_RECORD_SYNC : 0) |
+       (response[2] & FIELD_RDS_STATUS_RESP2_FIFO_OVERFLOW ? RDS_RECORD_OVERFLOW : 0);
+      _rds_sink(record);
+   }
+ #endif
+   //Get number of RDS groups (packets) available
+   return response[3];
+}
+
+// Saves info common to all groups, then passes group to its handler.
+// ***** PRIVATE *****
+bool Si4735::decode_group(const byte *response){
+   bool new_info=false;
+   /* Because PI is resent in every packet's Block A, we told the radio its OK to
+    * give us packets with a corrupted Block A.  A corrupted PI has no weight.
+    */
+   //Get PI code
+   word pi = MAKE_WORD(response[RDS_BLOCK_A_H], response[RDS_BLOCK_A_L]);
+   new_info |= rds_vote(CONF_PI, &rds.programId, &pi, sizeof(pi), rds_weight(response, BLOCK_A));
+ #ifdef Si47xx_RDS_CACHE
+   if(_rds_cached_pi && rds_weight(response, BLOCK_A)==4){
+      rds_cache_check(pi);
+      new_info=true;
+   }
+ #endif
+   byte weight = rds_weight(response, BLOCK_B);
+   //Get PTY code
+   byte pty = ((response[RDS_BLOCK_B_H] & 0b00000011) << 3U) | (response[RDS_BLOCK_B_L] >> 5U);
+   new_info |= rds_vote(CONF_PTY, &rds.programType, &pty, 1, weight);
+   //Get Traffic Program bit
+   ternary tp = bool(response[RDS_BLOCK_B_H] & 0b00000100);
+   new_info |= rds_vote(CONF_TP, &rds.trafficProgram, &tp, 1, weight);
+
+   //Get group type (0-15) and version (0=A, 1=B).  Together they index the handler table.
+   byte group = response[RDS_BLOCK_B_H]>>3U;
+   byte type = group>>1U;
+
+   //Save which group type and version was received
+   if(group & 1){
+      rds.groupB |= 1U<<type;
+   }else{
+      rds.groupA |= 1U<<type;
+   }
+
+   //Decode rest of group
+   RDSGroupHandler handler;
+ #ifdef Si47xx_RDS_ERT
+   //Group type assigned to eRT by group 3A
+   if(group==ert.group) handler = rds_group_ert;
+   else
+ #endif
+ #ifdef Si47xx_RDS_RTPLUS
+   //Group type assigned to RT+ by group 3A
+   if(group==rtPlus.group) handler = rds_group_rtplus;
+   else
+ #endif
+ #ifdef Si47xx_RDS_HANDLERS
+   handler = _rds_handlers[group];
+ #elif defined(__AVR__)
+   handler = (RDSGroupHandler)pgm_read_word(&rds_default_handlers[group]);
+ #else
+   handler = rds_default_handlers[group];
+ #endif
+   if(handler && handler(this, response)) new_info=true;
+   return new_info;
+}
+
+// Weight of a vote is 4 for no errors, 2 for 1-2 bit errors, 1 for 3-5 bit errors,
+// and 0 if uncorrectable.  The block with the most errors decides.
+// ***** PRIVATE *****
+byte Si4735::rds_weight(const byte *group, byte blocks){
+   byte errors = group[RDS_BLOCK_ERRORS] & blocks;
+   byte worst=0;
+   for(byte i=0; i<4; i++){
+      byte level = errors & 0b11;
+      if(level>worst) worst=level;
+      errors >>= 2;
+   }
+   return 4>>worst;
+}
+
+// Casts a vote for the value received for an RDS field.  See RDS_THRESHOLD.
+// ***** PRIVATE *****
+bool Si4735::rds_vote(byte field, void *candidate, const void *value, byte size, byte weight){
+   byte *confidence = &_confidence[field];
+   bool changed=false;
+   if(!weight) return false;
+   if(memcmp(candidate, value, size)==0){
+      //Vote for current value
+      *confidence += weight;
+      if(*confidence>RDS_CONFIDENCE_MAX) *confidence=RDS_CONFIDENCE_MAX;
+   }else if(*confidence>weight){
+      //Vote against current value
+      *confidence -= weight;
+   }else{
+      //Current value has lost - replace it
+      memcpy(candidate, value, size);
+      *confidence=weight;
+      changed=true;
+    #ifdef Si47xx_RDS_UTF8
+      //Radio Text segment needs translating again
+      if(field>=CONF_RT) _utf8_dirty |= 1U<<(field-CONF_RT);
+    #endif
+   }
+ #ifdef Si47xx_RDS_STABLE
+   //Copy trusted value to rdsStable
+   byte threshold = (CONF_TP<=field && field<CONF_ECC) ? RDS_BOOL_THRESHOLD : RDS_THRESHOLD;
+   if(*confidence>=threshold){
+      byte *stable = (byte *)&rdsStable + ((byte *)candidate-(byte *)&rds);
+      if(memcmp(stable, candidate, size)!=0){
+         memcpy(stable, candidate, size);
+         if(field<CONF_DI) _rds_changes |= 1U<<field;  //PI, PTY, TP, TA, MUSIC
+         else if(field<CONF_ECC) _rds_changes |= RDS_CHANGED_DI;
+         else if(field<CONF_PS) _rds_changes |= RDS_CHANGED_ECC<<(field-CONF_ECC);
+         else if(field<CONF_PTYN) _rds_changes |= RDS_CHANGED_PS;
+         else if(field<CONF_RT) _rds_changes |= RDS_CHANGED_PTYN;
+         else _rds_changes |= RDS_CHANGED_RT;
       }
+   }
+ #endif
+   return changed;
+}
 
-      //Groups 0A & 0B - Basic tuning and switching information
-      //Group 15B - Fast basic tuning and switching information
-      /* Note: We support both Groups 0 and 15B in case the station has poor
-       * reception and RDS packets are barely getting through.  This increases
-       * the chances of receiving this info.
-       */
-      if(type==0 || (type==15 && version==1)){
-         //Various flags
-         rds.trafficAlert = bool(response[Block_B_L] & 0b00010000);
-         rds.music =        bool(response[Block_B_L] & 0b00001000);
-         bool DI =               response[Block_B_L] & 0b00000100;
-
-         //Get segment number
-         segment =               response[Block_B_L] & 0b00000011;
-         //Handle DI code
-         switch(segment){
-         case 0:
-            rds.dynamicPTY=DI;
-            break;
-         case 1:
-            rds.compressedAudio=DI;
-            break;
-         case 2:
-            rds.binauralAudio=DI;
-            break;
-         case 3:
-            rds.RDSStereo=DI;
-            break;
-         }
+#ifdef Si47xx_RDS_STABLE
+word Si4735::getRDSChanges(){
+   word changes=_rds_changes;
+   _rds_changes=0;
+   return changes;
+}
+#endif
+
+#ifdef Si47xx_RDS_CACHE
+// ***** PRIVATE *****
+void Si4735::rds_cache_save(){
+   if(_mode!=FM || !_frequency || _confidence[CONF_PI]<RDS_THRESHOLD) return;
+   //Drop old entry of station, or least recent entry if cache is full
+   byte last=0;
+   while(last<_rds_cache_count && _rds_cache[last].frequency!=_frequency) last++;
+   if(last==_rds_cache_count){
+      if(_rds_cache_count<Si47xx_RDS_CACHE) _rds_cache_count++;
+      else last--;
+   }
+   //Move others down and put station first
+   memmove(&_rds_cache[1], &_rds_cache[0], last*sizeof(_rds_cache[0]));
+   _rds_cache[0].frequency=_frequency;
+   _rds_cache[0].programId=rds.programId;
+   _rds_cache[0].programType=rds.programType;
+   _rds_cache[0].extendedCountryCode=rds.extendedCountryCode;
+   memcpy(_rds_cache[0].programService, rds.programService, sizeof(_rds_cache[0].programService));
+}
+
+// Restored values have no confidence, so the first vote for another value replaces them.
+// ***** PRIVATE *****
+void Si4735::rds_cache_restore(){
+   if(_mode!=FM) return;
+   for(byte i=0; i<_rds_cache_count; i++){
+      if(_rds_cache[i].frequency!=_frequency) continue;
+      rds.programId=_rds_cache[i].programId;
+      rds.programType=_rds_cache[i].programType;
+      rds.extendedCountryCode=_rds_cache[i].extendedCountryCode;
+      memcpy(rds.programService, _rds_cache[i].programService, sizeof(_rds_cache[i].programService));
+      _rds_cached_pi=rds.programId;
+      //Entry stays until station is left, then rds_cache_save() moves it first
+      return;
+   }
+}
+
+// ***** PRIVATE *****
+void Si4735::rds_cache_check(word programId){
+   if(programId==_rds_cached_pi){
+    #ifdef Si47xx_RDS_STABLE
+      //Confirmed.  Trust restored values.
+      rdsStable.programId=rds.programId;
+      rdsStable.programType=rds.programType;
+      rdsStable.extendedCountryCode=rds.extendedCountryCode;
+      memcpy(rdsStable.programService, rds.programService, sizeof(rds.programService)-1);
+      _rds_changes |= RDS_CHANGED_PI | RDS_CHANGED_PTY | RDS_CHANGED_ECC | RDS_CHANGED_PS;
+    #endif
+   }else{
+      //Another station is on the frequency now
+      rds.programType=0;
+      rds.extendedCountryCode=ECC_UNKNOWN;
+      for(byte i=0; i<sizeof(rds.programService)-1; i++) rds.programService[i]=' ';
+   }
+   _rds_cached_pi=0;
+}
 
-         //Groups 0A & 0B
-         if(type==0){
-            //Program Service
-            char *ps = &rds.programService[segment*2];
-            *ps++ = make_printable(response[Block_D_H]);
-            *ps   = make_printable(response[Block_D_L]);
+void Si4735::clearRDSCache(){
+   _rds_cache_count=0;
+}
+#endif
+
+#ifdef Si47xx_RDS_HANDLERS
+RDSGroupHandler Si4735::setRDSGroupHandler(byte type, byte version, RDSGroupHandler handler){
+   byte group = (type<<1U | (version&1)) & (RDS_GROUP_TYPES-1);
+   RDSGroupHandler previous = _rds_handlers[group];
+   _rds_handlers[group] = handler;
+   return previous;
+}
+#endif
+
+// Groups 0A & 0B - Basic tuning and switching information
+// Group 15B - Fast basic tuning and switching information
+/* Note: We support both Groups 0 and 15B in case the station has poor
+ * reception and RDS packets are barely getting through.  This increases
+ * the chances of receiving this info.
+ */
+// ***** PRIVATE *****
+bool Si4735::rds_group_0(Si4735 *radio, const byte *group){
+   bool new_info=false;
+   byte weight = rds_weight(group, BLOCK_B);
+   //Various flags
+   ternary flag = bool(group[RDS_BLOCK_B_L] & 0b00010000);
+   new_info |= radio->rds_vote(CONF_TA, &radio->rds.trafficAlert, &flag, 1, weight);
+   flag =         bool(group[RDS_BLOCK_B_L] & 0b00001000);
+   new_info |= radio->rds_vote(CONF_MUSIC, &radio->rds.music, &flag, 1, weight);
+   ternary DI =   bool(group[RDS_BLOCK_B_L] & 0b00000100);
+
+   //Get segment number
+   byte segment =      group[RDS_BLOCK_B_L] & 0b00000011;
+   //Handle DI code
+   ternary *di_flag;
+   switch(segment){
+   case 0:
+      di_flag=&radio->rds.dynamicPTY;
+      break;
+   case 1:
+      di_flag=&radio->rds.compressedAudio;
+      break;
+   case 2:
+      di_flag=&radio->rds.binauralAudio;
+      break;
+   default:
+      di_flag=&radio->rds.RDSStereo;
+      break;
+   }
+   new_info |= radio->rds_vote(CONF_DI+segment, di_flag, &DI, 1, weight);
+
+   //Groups 0A & 0B
+   if(group[RDS_BLOCK_B_H]>>4U == 0){
+      //Program Service
+      char ps[2];
+      ps[0] = make_printable(group[RDS_BLOCK_D_H]);
+      ps[1] = make_printable(group[RDS_BLOCK_D_L]);
+      new_info |= radio->rds_vote(CONF_PS+segment, &radio->rds.programService[segment*2],
+       ps, sizeof(ps), rds_weight(group, BLOCK_B|BLOCK_D));
+   }
+ #ifdef Si47xx_RDS_AF
+   //Group 0A - Alternative Frequencies.  The list is only given to a trusted PI.
+   if(group[RDS_BLOCK_B_H]>>3U == 0 && rds_weight(group, BLOCK_C)>=2 &&
+    radio->_confidence[CONF_PI]>=RDS_THRESHOLD){
+      new_info |= radio->af_decode(group[RDS_BLOCK_C_H], group[RDS_BLOCK_C_L]);
+   }
+ #endif
+   return new_info;
+}
+
+#ifdef Si47xx_RDS_AF
+// AF codes arrive two per group.  A list starts with AF_CODE_NO_AF+n and an AF.
+/* Method A: The AFs of the list follow in pairs.
+ * Method B: Used when a station has many transmitters.  Each transmitter gets its own
+ *    list, headed by the transmitter's frequency.  Each pair holds the head frequency and
+ *    an AF.  Pairs in increasing order carry the same program, in decreasing order a
+ *    regional variant.
+ * A pair that holds the head frequency is taken as method B.  Pairs received before the
+ * first head are skipped.
+ */
+// ***** PRIVATE *****
+bool Si4735::af_decode(byte first, byte second){
+   //AF stations heard by checkAF() send their own lists
+   if(_af_searching) return false;
+   bool new_info=false;
+   if(afList.programId!=rds.programId){
+      //New station
+      afList.programId=rds.programId;
+      afList.count=0;
+      _af_header=0;
+      new_info=true;
+   }
+   //Skip LF/MF frequencies
+   if(_af_lfmf){
+      _af_lfmf=false;
+      first=AF_CODE_FILLER;
+   }
+   if(first==AF_CODE_LFMF) second=AF_CODE_FILLER;
+   if(second==AF_CODE_LFMF) _af_lfmf=true;
+
+   if(AF_CODE_NO_AF<first && first<AF_CODE_LFMF){
+      //Head of list
+      _af_header=second;
+      return af_add(second) || new_info;
+   }
+   //Method is not known until head of a list is seen
+   if(!_af_header) return new_info;
+   if(first==_af_header || second==_af_header){
+      //Method B.  Only the tuned transmitter's list is used.
+      byte tuned = (_frequency-8750U)/10U;
+      if(_af_header!=tuned || first>second) return new_info;
+      return af_add(first==_af_header ? second : first) || new_info;
+   }
+   //Method A
+   new_info |= af_add(first);
+   new_info |= af_add(second);
+   return new_info;
+}
+
+// ***** PRIVATE *****
+bool Si4735::af_add(byte code){
+   if(code<AF_CODE_MIN || code>AF_CODE_MAX) return false;
+   if(afList.count>=Si47xx_RDS_AF) return false;
+   if(memchr(afList.frequencies, code, afList.count)) return false;
+   afList.frequencies[afList.count++]=code;
+   return true;
+}
+
+void Si4735::setAFFollow(byte minRSSI, byte minSNR){
+   _af_min_rssi=minRSSI;
+   _af_min_snr=minSNR;
+   _af_hold=false;
+}
+
+word Si4735::checkAF(IdleCallback idle){
+   //Only follow the station the list belongs to
+   if((!_af_min_rssi && !_af_min_snr) || _mode!=FM || !_frequency) return 0;
+   if(!afList.count || afList.programId!=rds.programId) return 0;
+   //Give the listener some audio between failed searches
+   if(_af_hold && millis()-_af_hold_start < RADIO_AF_RETRY) return 0;
+   RSQMetrics RSQ;
+   getRSQ(&RSQ);
+   if(RSQ.RSSI>=_af_min_rssi && RSQ.SNR>=_af_min_snr) return 0;
+
+   word home=_frequency;
+   word programId=afList.programId;
+   //Work from a copy of the list.  Groups decoded while checking PI must not change it.
+   byte count=afList.count;
+   byte frequencies[Si47xx_RDS_AF];
+   memcpy(frequencies, afList.frequencies, count);
+   _af_searching=true;
+   bool muted=_mute;
+   if(!muted) mute();
+   //Measure each AF.  The AFs carry the same program, so station info is kept.
+   byte RSSI[Si47xx_RDS_AF];
+   memset(RSSI, 0, sizeof(RSSI));
+   for(byte i=0; i<count; i++){
+      word frequency=AF_FREQUENCY(frequencies[i]);
+      if(frequency==home) continue;
+      tune_frequency(frequency, 0, false);
+      if(waitSTC(RADIO_TUNE_TIMEOUT, idle)!=RADIO_OK) continue;
+      RSQMetrics AF;
+      getRSQ(&AF);
+      RSSI[i]=AF.RSSI;
+   }
+   //Try AFs stronger than current signal, strongest first
+   word found=0;
+   for(;;){
+      byte best=0xFF;
+      for(byte i=0; i<count; i++){
+         if(RSSI[i]>RSQ.RSSI && (best==0xFF || RSSI[i]>RSSI[best])) best=i;
+      }
+      if(best==0xFF) break;
+      RSSI[best]=0;
+      tune_frequency(AF_FREQUENCY(frequencies[best]), 0, false);
+      if(waitSTC(RADIO_TUNE_TIMEOUT, idle)==RADIO_OK && af_check_pi(programId, idle)){
+         found=_frequency;
+         break;
+      }
+   }
+   _af_searching=false;
+   _af_hold=!found;
+   if(!found){
+      _af_hold_start=millis();
+      tune_frequency(home, 0, false);
+      waitSTC(RADIO_TUNE_TIMEOUT, idle);
+   }
+   if(!muted) unmute();
+   return found;
+}
+
+// Groups are not decoded, so groups from another station cannot change rds.
+// ***** PRIVATE *****
+bool Si4735::af_check_pi(word programId, IdleCallback idle){
+   byte response[RDS_STATUS_LENGTH];
+   unsigned long start=millis();
+   while(millis()-start < RADIO_AF_PI_TIMEOUT){
+      if(read_rds_group(response)){
+         //A PI with errors could match by chance
+         if(rds_weight(response, BLOCK_A)==4){
+            return MAKE_WORD(response[RDS_BLOCK_A_H], response[RDS_BLOCK_A_L])==programId;
          }
+      }
+      if(idle) idle();
+   }
+   return false;
+}
+#endif
+
+// Group 1A - Extended Country Code (ECC) and Language Code
+// ***** PRIVATE *****
+bool Si4735::rds_group_1A(Si4735 *radio, const byte *group){
+   //We are only interested in the Extended Country Code (ECC) and
+   //Language Code for this Group.
+   byte weight = rds_weight(group, BLOCK_B|BLOCK_C);
+
+   //Get Variant code
+   switch(group[RDS_BLOCK_C_H] & 0b01110000){
+   case (0<<4):  //Variant==0
+      //Extended Country Code
+      return radio->rds_vote(CONF_ECC, &radio->rds.extendedCountryCode,
+       &group[RDS_BLOCK_C_L], 1, weight);
+   case (3<<4):  //Variant==3
+      //Language Code
+      return radio->rds_vote(CONF_LANGUAGE, &radio->rds.language,
+       &group[RDS_BLOCK_C_L], 1, weight);
+   }
+   return false;
+}
+
+// Groups 2A & 2B - Radio Text
+// ***** PRIVATE *****
+bool Si4735::rds_group_2(Si4735 *radio, const byte *group){
+   bool new_info=false;
+   //Check A/B flag to see if Radio Text has changed.  A damaged flag would wipe out the
+   //message, so a change is only believed from a block without errors.
+   byte new_ab = bool(group[RDS_BLOCK_B_L] & 0b00010000);
+   if(new_ab != radio->_abRadioText &&
+    (radio->_abRadioText==unknown || rds_weight(group, BLOCK_B)==4)){
+      //New message found - clear buffer
+      radio->_abRadioText=new_ab;
+      for(byte i=0; i<sizeof(radio->rds.radioText)-1; i++) radio->rds.radioText[i]=' ';
+      radio->rds.radioTextLen=sizeof(radio->rds.radioText);  //Default to max length
+      memset(&radio->_confidence[CONF_RT], 0, 16);
+    #ifdef Si47xx_RDS_UTF8
+      radio->_utf8_dirty=0xFFFF;
+    #endif
+    #ifdef Si47xx_RDS_STABLE
+      memcpy(radio->rdsStable.radioText, radio->rds.radioText, sizeof(radio->rds.radioText));
+      radio->rdsStable.radioTextLen=radio->rds.radioTextLen;
+      radio->_rds_changes |= RDS_CHANGED_RT;
+    #endif
+      new_info=true;
+   }
+   //Get segment number
+   byte segment = group[RDS_BLOCK_B_L] & 0x0F;
+
+   //Get Radio Text
+   const byte *block;  //First char of segment
+   byte length;  //Chars in segment
+   byte weight;
+   if(!(group[RDS_BLOCK_B_H] & 0b00001000)){  // 2A
+      block = &group[RDS_BLOCK_C_H];
+      length=4;
+      weight=rds_weight(group, BLOCK_B|BLOCK_C|BLOCK_D);
+   }
+   else{  // 2B
+      block = &group[RDS_BLOCK_D_H];
+      length=2;
+      weight=rds_weight(group, BLOCK_D|BLOCK_B);
+   }
+   byte position = segment*length;  //Position of segment in rds.radioText[]
+   char text[4];
+   byte end=0xFF;  //Position of end of message marker
+   //Copy chars
+   for(byte i=0; i<length; i++){
+      //Get next char from segment
+      char ch = block[i];
+      //Check for end of message marker
+      if(ch=='\r' && end==0xFF) end=position+i;
+      text[i] = make_printable(ch);
+   }
+   char *rt = &radio->rds.radioText[position];
+   new_info |= radio->rds_vote(CONF_RT+segment, rt, text, length, weight);
+   //Save new message length if segment with end of message marker was kept
+   if(end!=0xFF && memcmp(rt, text, length)==0){
+      if(radio->rds.radioTextLen!=end){
+         radio->rds.radioTextLen=end;
          new_info=true;
       }
-      //Group 1A - Extended Country Code (ECC) and Language Code
-      else if(type==1 && version==0){
-         //We are only interested in the Extended Country Code (ECC) and
-         //Language Code for this Group.
-
-         //Get Variant code
-         switch(response[Block_C_H] & 0b01110000){
-         case (0<<4):  //Variant==0
-            //Extended Country Code
-            //Check if count has reached threshold
-            if(_extendedCountryCode_count < RDS_THRESHOLD){
-               byte ecc = response[Block_C_L];
-               //Check if datum changed
-               if(rds.extendedCountryCode != ecc){
-                  _extendedCountryCode_count=0;
-                  new_info=true;
-               }
-               //Save new data
-               rds.extendedCountryCode = ecc;
-               ++_extendedCountryCode_count;
-            }
-            break;
-         case (3<<4):  //Variant==3
-            //Language Code
-            //Check if count has reached threshold
-            if(_language_count < RDS_THRESHOLD){
-               byte language = response[Block_C_L];
-               //Check if datum changed
-               if(rds.language != language){
-                  _language_count=0;
-                  new_info=true;
-               }
-               //Save new data
-               rds.language = language;
-               ++_language_count;
-            }
-            break;
+    #ifdef Si47xx_RDS_STABLE
+      if(radio->_confidence[CONF_RT+segment]>=RDS_THRESHOLD && radio->rdsStable.radioTextLen!=end){
+         radio->rdsStable.radioTextLen=end;
+         radio->_rds_changes |= RDS_CHANGED_RT;
+      }
+    #endif
+   }
+   return new_info;
+}
+
+#if defined(Si47xx_RDS_RTPLUS) || defined(Si47xx_RDS_ERT)
+// Group 3A - Open Data Application (ODA) identification
+// Only RT+ and eRT are supported.  Block D gives the application, and block B gives the
+// group type and version the application's data will be sent in.
+// ***** PRIVATE *****
+bool Si4735::rds_group_3A(Si4735 *radio, const byte *group){
+   //A damaged AID or group type would send the wrong groups to a decoder
+   if(rds_weight(group, BLOCK_B|BLOCK_D)<2) return false;
+   word aid = MAKE_WORD(group[RDS_BLOCK_D_H], group[RDS_BLOCK_D_L]);
+   //Group type 00000 means no data groups; 11111 means temporary data fault
+   byte data_group = group[RDS_BLOCK_B_L] & 0b00011111;
+   if(data_group==0 || data_group==0b11111) return false;
+   byte *oda_group;
+ #ifdef Si47xx_RDS_RTPLUS
+   if(aid==RTPLUS_AID) oda_group=&radio->rtPlus.group;
+   else
+ #endif
+ #ifdef Si47xx_RDS_ERT
+   if(aid==ERT_AID){
+      //Block C bit 0: UTF-8 instead of UCS-2, bit 1: right to left
+      if(rds_weight(group, BLOCK_C)<2) return false;
+      radio->ert.utf8 = group[RDS_BLOCK_C_L] & 0b01;
+      radio->ert.rightToLeft = group[RDS_BLOCK_C_L] & 0b10;
+      oda_group=&radio->ert.group;
+   }else
+ #endif
+      return false;
+   if(*oda_group==data_group) return false;
+   *oda_group=data_group;
+   return true;
+}
+#endif
+
+#ifdef Si47xx_RDS_ERT
+// Enhanced RadioText - 4 bytes of text per group
+/* Block B bits 4-0 give the address of the 4 bytes in blocks C and D.  The end of the
+ * text is marked by 0x0D in UTF-8, or 0x000D in UCS-2.
+ */
+// ***** PRIVATE *****
+bool Si4735::rds_group_ert(Si4735 *radio, const byte *group){
+   //Text has no error checks of its own, so damaged blocks are dropped
+   if(rds_weight(group, BLOCK_B|BLOCK_C|BLOCK_D)<2) return false;
+   bool new_info=false;
+   byte position = (group[RDS_BLOCK_B_L] & 0b00011111)*4;
+   const byte *data = &group[RDS_BLOCK_C_H];
+   char *text = &radio->ert.text[position];
+   if(!radio->ert.length){
+      //No end of message marker yet
+      radio->ert.length=sizeof(radio->ert.text)-1;
+      new_info=true;
+   }
+   if(memcmp(text, data, 4)!=0){
+      memcpy(text, data, 4);
+      new_info=true;
+   }
+   for(byte i=0; i<4; i++){
+      //In UCS-2, 0x0D must be low byte of a char
+      if(data[i]=='\r' && (radio->ert.utf8 || ((i & 1) && !data[i-1]))){
+         byte end = radio->ert.utf8 ? position+i : position+i-1;
+         if(radio->ert.length!=end){
+            radio->ert.length=end;
+            new_info=true;
          }
+         break;
+      }
+   }
+   return new_info;
+}
+#endif
+
+#ifdef Si47xx_RDS_RTPLUS
+
+// RadioText Plus - Tags for Radio Text
+/* Group layout (37 bits of blocks B, C, and D):
+ *    Block B bit 4       Item toggle
+ *    Block B bit 3       Item running
+ *    Block B bits 2-0    Content type 1, high 3 bits
+ *    Block C bits 15-13  Content type 1, low 3 bits
+ *    Block C bits 12-7   Start marker 1
+ *    Block C bits 6-1    Length marker 1 (chars-1)
+ *    Block C bit 0       Content type 2, high bit
+ *    Block D bits 15-11  Content type 2, low 5 bits
+ *    Block D bits 10-5   Start marker 2
+ *    Block D bits 4-0    Length marker 2 (chars-1)
+ */
+// ***** PRIVATE *****
+bool Si4735::rds_group_rtplus(Si4735 *radio, const byte *group){
+   //Markers with 3-5 bit errors would copy the wrong text
+   if(rds_weight(group, BLOCK_B|BLOCK_C|BLOCK_D)<2) return false;
+   bool new_info=false;
+   byte b = group[RDS_BLOCK_B_L];
+   word c = MAKE_WORD(group[RDS_BLOCK_C_H], group[RDS_BLOCK_C_L]);
+   word d = MAKE_WORD(group[RDS_BLOCK_D_H], group[RDS_BLOCK_D_L]);
+
+   //New item - forget old one
+   ternary toggle = bool(b & 0b10000);
+   if(toggle!=radio->rtPlus.toggle){
+      if(radio->rtPlus.toggle!=unknown){
+         radio->rtPlus.title[0]=radio->rtPlus.artist[0]=radio->rtPlus.album[0]='\0';
+         radio->_rtplus_changes |= RTPLUS_CHANGED_TITLE | RTPLUS_CHANGED_ARTIST | RTPLUS_CHANGED_ALBUM;
+         new_info=true;
       }
-      //Groups 2A & 2B - Radio Text
-      else if(type==2){
-         //Check A/B flag to see if Radio Text has changed
-         byte new_ab = bool(response[Block_B_L] & 0b00010000);
-         if(new_ab != _abRadioText){
-            //New message found - clear buffer
-            _abRadioText=new_ab;
-            for(byte i=0; i<sizeof(rds.radioText)-1; i++) rds.radioText[i]=' ';
-            rds.radioTextLen=sizeof(rds.radioText);  //Default to max length
+      radio->rtPlus.toggle=toggle;
+   }
+   bool running = b & 0b01000;
+   if(running!=radio->rtPlus.running){
+      radio->rtPlus.running=running;
+      radio->_rtplus_changes |= RTPLUS_CHANGED_RUNNING;
+      new_info=true;
+   }
+
+   //Get tags
+   radio->rtPlus.tags[0].type   = (b & 0b111)<<3U | c>>13U;
+   radio->rtPlus.tags[0].start  = (c>>7U) & 0x3F;
+   radio->rtPlus.tags[0].length = ((c>>1U) & 0x3F) + 1;
+   radio->rtPlus.tags[1].type   = (c & 1)<<5U | d>>11U;
+   radio->rtPlus.tags[1].start  = (d>>5U) & 0x3F;
+   radio->rtPlus.tags[1].length = (d & 0x1F) + 1;
+
+   //Copy tagged text
+   for(byte i=0; i<2; i++){
+      byte start = radio->rtPlus.tags[i].start;
+      byte length = radio->rtPlus.tags[i].length;
+      switch(radio->rtPlus.tags[i].type){
+      case RTPLUS_ITEM_TITLE:
+         if(radio->rtplus_extract(radio->rtPlus.title, start, length)){
+            radio->_rtplus_changes |= RTPLUS_CHANGED_TITLE;
+            new_info=true;
          }
-         //Get segment number
-         segment = response[Block_B_L] & 0x0F;
-
-         //Get Radio Text
-         char *rt;  //Next position in rds.radioText[]
-         byte *block;  //Next char from segment
-         byte i;  //Loop counter
-         //TODO maybe: convert RDS non ASCII chars to UTF-8 for terminal interface
-         if(version==0){  // 2A
-            rt = &rds.radioText[segment*4];
-            block = &response[Block_C_H];
-            i=4;
+         break;
+      case RTPLUS_ITEM_ARTIST:
+         if(radio->rtplus_extract(radio->rtPlus.artist, start, length)){
+            radio->_rtplus_changes |= RTPLUS_CHANGED_ARTIST;
+            new_info=true;
          }
-         else{  // 2B
-            rt = &rds.radioText[segment*2];
-            block = &response[Block_D_H];
-            i=2;
+         break;
+      case RTPLUS_ITEM_ALBUM:
+         if(radio->rtplus_extract(radio->rtPlus.album, start, length)){
+            radio->_rtplus_changes |= RTPLUS_CHANGED_ALBUM;
+            new_info=true;
          }
-         //Copy chars
-         do{
-            //Get next char from segment
-            char ch = *block++;
-            //Check for end of message marker
-            if(ch=='\r'){
-               //Save new message length
-               rds.radioTextLen = rt-rds.radioText;
-            }
-            //Put next char in rds.radioText[]
-            *rt++ = make_printable(ch);
-         }while(--i);
+         break;
+      }
+   }
+   return new_info;
+}
+
+// Only the tagged chars are compared and copied.  Nothing is copied until every Radio
+// Text segment holding the tagged chars has reached RDS_THRESHOLD.
+// ***** PRIVATE *****
+bool Si4735::rtplus_extract(char *field, byte start, byte length){
+   //Segment size: 4 chars for group 2A, 2 chars for 2B
+   byte size = (rds.groupA & 1U<<2) ? 4 : 2;
+   //Radio Text has 16 segments: 64 chars for 2A, 32 chars for 2B
+   if(start+length > 16*size) return false;
+   for(byte segment=start/size; segment<=(start+length-1)/size; segment++){
+      if(_confidence[CONF_RT+segment] < RDS_THRESHOLD) return false;
+   }
+   if(length>Si47xx_RDS_RTPLUS) length=Si47xx_RDS_RTPLUS;
+   const char *text = &rds.radioText[start];
+   if(memcmp(field, text, length)==0 && field[length]=='\0') return false;
+   memcpy(field, text, length);
+   field[length]='\0';
+   return true;
+}
+
+byte Si4735::getRTPlusChanges(){
+   byte changes=_rtplus_changes;
+   _rtplus_changes=0;
+   return changes;
+}
+#endif
+
+// Group 4A - Clock-time and date
+// ***** PRIVATE *****
+bool Si4735::rds_group_4A(Si4735 *radio, const byte *group){
+   //Only use if received perfectly.
+   /* Note: Error Correcting Codes (ECC) are not perfect.  It is possible
+    * for a block to be damaged enough that the ECC thinks the data is OK
+    * when it's damaged or that it can recover when it cannot.  Because
+    * date and time are useless unless accurate, we require that the date
+    * and time be received perfectly to increase the odds of accurate data.
+    */
+   if( (group[RDS_BLOCK_ERRORS] & (FIELD_RDS_STATUS_RESP12_BLOCK_B |
+    FIELD_RDS_STATUS_RESP12_BLOCK_C | FIELD_RDS_STATUS_RESP12_BLOCK_D)) !=
+    (RDS_STATUS_RESP12_BLOCK_B_NO_ERRORS | RDS_STATUS_RESP12_BLOCK_C_NO_ERRORS |
+    RDS_STATUS_RESP12_BLOCK_D_NO_ERRORS) ){
+      return false;
+   }
+   //Get Modified Julian Date (MJD)
+   radio->rds.MJD = (group[RDS_BLOCK_B_L] & 0b00000011)<<15UL | group[RDS_BLOCK_C_H]<<7U | group[RDS_BLOCK_C_L]>>1U;
+
+   //Get hour and minute
+   radio->rds.hour = (group[RDS_BLOCK_C_L] & 0b00000001)<<4U | group[RDS_BLOCK_D_H]>>4U;
+   radio->rds.minute = (group[RDS_BLOCK_D_H] & 0x0F)<<2U | group[RDS_BLOCK_D_L]>>6U;
+
+   //Check if date and time sent (not 0)
+   if(radio->rds.MJD || radio->rds.hour || radio->rds.minute || group[RDS_BLOCK_D_L]){
+      //Get offset to convert UTC to local time
+      radio->rds.offset = group[RDS_BLOCK_D_L]&0x1F;
+      //Check if offset should be negative
+      if(group[RDS_BLOCK_D_L] & 0b00100000){
+         radio->rds.offset = -radio->rds.offset;  //Make it negative
+      }
+    #ifdef Si47xx_RDS_STABLE
+      //Perfect blocks are trusted at once
+      radio->rdsStable.MJD   =radio->rds.MJD;
+      radio->rdsStable.hour  =radio->rds.hour;
+      radio->rdsStable.minute=radio->rds.minute;
+      radio->rdsStable.offset=radio->rds.offset;
+      radio->_rds_changes |= RDS_CHANGED_TIME;
+    #endif
+      return true;
+   }
+   return false;
+}
+
+#ifdef Si47xx_RDS_TMC
+// Group 8A - Traffic Message Channel (ISO 14819-1)
+/* Block B bit 4 is set for tuning info, which is ignored.  Otherwise bit 3 is set for a
+ * single group message and bits 2-0 give its duration.  For a multi-group message, bits
+ * 2-0 give a continuity index shared by all its groups.
+ * Single group and first group of a multi-group message:
+ *    Block C bit 15      Diversion advised (single group) or first group flag (multi-group)
+ *    Block C bit 14      Direction: 1 is negative
+ *    Block C bits 13-11  Extent
+ *    Block C bits 10-0   Event code
+ *    Block D             Location code
+ * Later groups of a multi-group message:
+ *    Block C bit 14      Second group flag
+ *    Block C bits 13-12  Group sequence indicator: groups left after this one
+ *    Block C bits 11-0   Free format data, followed by all 16 bits of block D
+ */
+// ***** PRIVATE *****
+bool Si4735::rds_group_8A(Si4735 *radio, const byte *group){
+   //Damaged events would be queued as new events
+   if(rds_weight(group, BLOCK_B|BLOCK_C|BLOCK_D)<2) return false;
+   byte flags = group[RDS_BLOCK_B_L] & 0b00011111;
+   if(flags & 0b10000) return false;  //Tuning info
+   word c = MAKE_WORD(group[RDS_BLOCK_C_H], group[RDS_BLOCK_C_L]);
+   word d = MAKE_WORD(group[RDS_BLOCK_D_H], group[RDS_BLOCK_D_L]);
+   TMCEvent *message = &radio->_tmc_message;
+   bool first = c & 0x8000;
+   if((flags & 0b01000) || first){
+      //Single group, or first group of multi-group message
+      message->event   =c & 0x07FF;
+      message->location=d;
+      message->extent  =(c>>11) & 0b111;
+      message->negative=c & 0x4000;
+      if(flags & 0b01000){
+         message->duration =flags & 0b111;
+         message->diversion=first;
+         radio->_tmc_ci=0xFF;  //Any multi-group message was interrupted
+         return radio->tmc_add(message);
+      }
+      //Rest of message is in free format groups
+      message->duration =0;
+      message->diversion=false;
+      radio->_tmc_ci=flags & 0b111;
+      radio->_tmc_groups=0;
+      return false;
+   }
+
+   //Later group of multi-group message
+   if((flags & 0b111)!=radio->_tmc_ci) return false;
+   byte sequence = (c>>12) & 0b11;
+   unsigned long bits = (unsigned long)(c & 0x0FFF)<<16 | d;
+   if(c & 0x4000){
+      //Second group starts free format data
+      radio->_tmc_groups=0;
+   }else if(radio->_tmc_groups && sequence==radio->_tmc_next+1 &&
+    radio->_tmc_bits[radio->_tmc_groups-1]==bits){
+      //Station repeated last group
+      return false;
+   }else if(!radio->_tmc_groups || sequence!=radio->_tmc_next){
+      //Missed a group - drop message
+      radio->_tmc_ci=0xFF;
+      return false;
+   }
+   if(radio->_tmc_groups>=4){
+      radio->_tmc_ci=0xFF;
+      return false;
+   }
+   radio->_tmc_bits[radio->_tmc_groups++]=bits;
+   radio->_tmc_next=sequence-1;
+   if(sequence) return false;  //More groups to come
+
+   //Message complete
+   radio->tmc_labels();
+   radio->_tmc_ci=0xFF;
+   return radio->tmc_add(message);
+}
+
+// Returns length bits of TMC free format data starting at position.  Each entry of
+// chunks holds 28 bits, high bit first.
+// ***** PRIVATE *****
+static word tmc_bits(const unsigned long *chunks, byte position, byte length){
+   word value=0;
+   for(byte i=0; i<length; i++, position++){
+      value = value<<1 | (chunks[position/28]>>(27-position%28) & 1);
+   }
+   return value;
+}
+
+// Free format data is a list of 4 bit labels, each followed by data of a fixed size.
+// Only duration (label 0) and detailed diversion (label 10) are used.  Label 14 separates
+// extra events, which are ignored.
+// ***** PRIVATE *****
+void Si4735::tmc_labels(){
+   static const byte PROGMEM label_bits[16]={3, 3, 5, 5, 5, 8, 8, 8, 8, 11, 16, 16, 16, 16, 0, 0};
+   byte total = _tmc_groups*28;
+   byte position=0;
+   while(position+4<=total){
+      byte label = tmc_bits(_tmc_bits, position, 4);
+      byte length = pgm_read_byte(&label_bits[label]);
+      position+=4;
+      if(label>=14 || position+length>total) return;
+      word value = tmc_bits(_tmc_bits, position, length);
+      position+=length;
+      if(label==0 && value) _tmc_message.duration=value;
+      else if(label==10) _tmc_message.diversion=true;
+   }
+}
+
+// Hashes of recent events are kept in a small table indexed by hash.  A new event
+// replaces whatever shared its slot, so the table never fills.
+// ***** PRIVATE *****
+bool Si4735::tmc_add(const TMCEvent *event){
+   word hash = event->location;
+   hash = hash*31 + event->event;
+   hash = hash*31 + (event->extent | event->negative<<3 | event->duration<<4 | event->diversion<<7);
+   if(!hash) hash=1;  //0 marks an empty slot
+   word *seen = &_tmc_seen[(hash ^ hash>>8) & (RDS_TMC_SEEN-1)];
+   if(*seen==hash) return false;
+   //Not remembered while queue is full, so a repeat can be queued later
+   if(_tmc_count==Si47xx_RDS_TMC) return false;
+   *seen=hash;
+   byte tail=_tmc_head+_tmc_count;
+   if(tail>=Si47xx_RDS_TMC) tail-=Si47xx_RDS_TMC;
+   _tmc_queue[tail]=*event;
+   _tmc_count++;
+   return true;
+}
+
+bool Si4735::getTMCEvent(TMCEvent *event){
+   if(!_tmc_count) return false;
+   *event=_tmc_queue[_tmc_head];
+   if(++_tmc_head==Si47xx_RDS_TMC) _tmc_head=0;
+   _tmc_count--;
+   return true;
+}
+
+byte Si4735::queuedTMCEvents(){
+   return _tmc_count;
+}
+#endif
+
+// Group 10A - Program Type Name
+// ***** PRIVATE *****
+bool Si4735::rds_group_10A(Si4735 *radio, const byte *group){
+   bool new_info=false;
+   //Check A/B flag to see if Program Type Name has changed.  As with Radio Text, only
+   //believe a change from a block without errors.
+   byte new_ab = bool(group[RDS_BLOCK_B_L] & 0b00010000);
+   if(new_ab != radio->_abProgramTypeName &&
+    (radio->_abProgramTypeName==unknown || rds_weight(group, BLOCK_B)==4)){
+      //New name found - clear buffer
+      radio->_abProgramTypeName=new_ab;
+      for(byte i=0; i<sizeof(radio->rds.programTypeName)-1; i++) radio->rds.programTypeName[i]=' ';
+      memset(&radio->_confidence[CONF_PTYN], 0, 2);
+    #ifdef Si47xx_RDS_STABLE
+      memcpy(radio->rdsStable.programTypeName, radio->rds.programTypeName, sizeof(radio->rds.programTypeName));
+      radio->_rds_changes |= RDS_CHANGED_PTYN;
+    #endif
+      new_info=true;
+   }
+   //Get segment number
+   byte segment = group[RDS_BLOCK_B_L] & 0x01;
+
+   //Get Program Type Name
+   char name[4];
+   name[0] = make_printable(group[RDS_BLOCK_C_H]);
+   name[1] = make_printable(group[RDS_BLOCK_C_L]);
+   name[2] = make_printable(group[RDS_BLOCK_D_H]);
+   name[3] = make_printable(group[RDS_BLOCK_D_L]);
+   new_info |= radio->rds_vote(CONF_PTYN+segment, &radio->rds.programTypeName[segment*4],
+    name, sizeof(name), rds_weight(group, BLOCK_B|BLOCK_C|BLOCK_D));
+   return new_info;
+}
+
+#ifdef Si47xx_RDS_EON
+ #define RDS_GROUP_14 rds_group_14
+#else
+ #define RDS_GROUP_14 0
+#endif
+
+#ifdef Si47xx_RDS_TMC
+ #define RDS_GROUP_8A rds_group_8A
+#else
+ #define RDS_GROUP_8A 0
+#endif
+
+#if defined(Si47xx_RDS_RTPLUS) || defined(Si47xx_RDS_ERT)
+ #define RDS_GROUP_3A rds_group_3A
+#else
+ #define RDS_GROUP_3A 0
+#endif
+
+#ifdef Si47xx_RDS_EON
+// Groups 14A & 14B - Enhanced Other Networks
+/* Block D gives PI of the other network (ON), and block B bit 4 its TP flag.
+ * 14B: Block B bit 3 is the ON's TA flag.
+ * 14A: Block B bits 3-0 give the variant of info in block C:
+ *    0-3    PS, 2 chars each
+ *    4      AFs, method A
+ *    5-8    Mapped FM frequencies: tuned frequency in high byte, ON's frequency in low byte
+ *    13     PTY in bits 15-11, TA in bit 0
+ *    Others are not used.
+ */
+// ***** PRIVATE *****
+bool Si4735::rds_group_14(Si4735 *radio, const byte *group){
+   //Damaged PI would make a false station
+   if(rds_weight(group, BLOCK_B|BLOCK_D)<2) return false;
+   word pi = MAKE_WORD(group[RDS_BLOCK_D_H], group[RDS_BLOCK_D_L]);
+   if(!pi || pi==radio->rds.programId) return false;
+   EONStation *station = &radio->eon[radio->eon_entry(pi)];
+   bool new_info=false;
+   ternary tp = bool(group[RDS_BLOCK_B_L] & 0b00010000);
+   if(station->trafficProgram!=tp){
+      station->trafficProgram=tp;
+      new_info=true;
+   }
+   if(group[RDS_BLOCK_B_H] & 0b00001000){  // 14B
+      ternary ta = bool(group[RDS_BLOCK_B_L] & 0b00001000);
+      if(station->trafficAlert!=ta){
+         station->trafficAlert=ta;
          new_info=true;
       }
-      //Group 4A - Clock-time and date
-      else if(type==4 && version==0){
-         //Only use if received perfectly.
-         /* Note: Error Correcting Codes (ECC) are not perfect.  It is possible
-          * for a block to be damaged enough that the ECC thinks the data is OK
-          * when it's damaged or that it can recover when it cannot.  Because
-          * date and time are useless unless accurate, we require that the date
-          * and time be received perfectly to increase the odds of accurate data.
-          */
-         if( (response[12] & (FIELD_RDS_STATUS_RESP12_BLOCK_B |
-          FIELD_RDS_STATUS_RESP12_BLOCK_C | FIELD_RDS_STATUS_RESP12_BLOCK_D)) ==
-          (RDS_STATUS_RESP12_BLOCK_B_NO_ERRORS | RDS_STATUS_RESP12_BLOCK_C_NO_ERRORS |
-          RDS_STATUS_RESP12_BLOCK_D_NO_ERRORS) ){
-            //Get Modified Julian Date (MJD)
-            rds.MJD = (response[Block_B_L] & 0b00000011)<<15UL | response[Block_C_H]<<7U | response[Block_C_L]>>1U;
-
-            //Get hour and minute
-            rds.hour = (response[Block_C_L] & 0b00000001)<<4U | response[Block_D_H]>>4U;
-            rds.minute = (response[Block_D_H] & 0x0F)<<2U | response[Block_D_L]>>6U;
-
-            //Check if date and time sent (not 0)
-            if(rds.MJD || rds.hour || rds.minute || response[Block_D_L]){
-               //Get offset to convert UTC to local time
-               rds.offset = response[Block_D_L]&0x1F;
-               //Check if offset should be negative
-               if(response[Block_D_L] & 0b00100000){
-                  rds.offset = -rds.offset;  //Make it negative
-               }
-               new_info=true;
-            }
-         }
+      return new_info;
+   }
+   if(rds_weight(group, BLOCK_C)<2) return new_info;
+   byte variant = group[RDS_BLOCK_B_L] & 0x0F;
+   byte c_h = group[RDS_BLOCK_C_H], c_l = group[RDS_BLOCK_C_L];
+   byte ons[2]={0, 0};  //AF codes of ON
+   switch(variant){
+   case 0: case 1: case 2: case 3: {
+      char *ps = &station->programService[variant*2];
+      char ch0 = make_printable(c_h), ch1 = make_printable(c_l);
+      if(ps[0]!=ch0 || ps[1]!=ch1){
+         ps[0]=ch0;
+         ps[1]=ch1;
+         new_info=true;
       }
-      //Group 10A - Program Type Name
-      else if(type==10 && version==0){
-         //Check A/B flag to see if Program Type Name has changed
-         byte new_ab = bool(response[Block_B_L] & 0b00010000);
-         if(new_ab != _abProgramTypeName){
-            //New name found - clear buffer
-            _abProgramTypeName=new_ab;
-            for(byte i=0; i<sizeof(rds.programTypeName)-1; i++) rds.programTypeName[i]=' ';
-         }
-         //Get segment number
-         segment = response[Block_B_L] & 0x01;
-
-         //Get Program Type Name
-         char *name = &rds.programTypeName[segment*4];
-         *name++ = make_printable(response[Block_C_H]);
-         *name++ = make_printable(response[Block_C_L]);
-         *name++ = make_printable(response[Block_D_H]);
-         *name   = make_printable(response[Block_D_L]);
+      break;
+   }
+   case 4:
+      ons[0]=c_h;
+      ons[1]=c_l;
+      break;
+   case 5: case 6: case 7: case 8:
+      //Only frequencies mapped from the tuned frequency
+      if(AF_FREQUENCY(c_h)==radio->_frequency) ons[0]=c_l;
+      break;
+   case 13: {
+      byte pty = c_h>>3U;
+      ternary ta = bool(c_l & 1);
+      if(station->programType!=pty || station->trafficAlert!=ta){
+         station->programType=pty;
+         station->trafficAlert=ta;
          new_info=true;
       }
+      break;
+   }
+   }
+   //Save new AFs
+   for(byte n=0; n<2; n++){
+      byte code=ons[n];
+      if(code<AF_CODE_MIN || code>AF_CODE_MAX) continue;
+      for(byte i=0; i<RDS_EON_AF; i++){
+         if(station->frequencies[i]==code) break;
+         if(!station->frequencies[i]){
+            station->frequencies[i]=code;
+            new_info=true;
+            break;
+         }
+      }
    }
    return new_info;
 }
 
+// ***** PRIVATE *****
+byte Si4735::eon_hash(word programId){
+   return (programId ^ programId>>8) & (Si47xx_RDS_EON-1);
+}
+
+// Open addressing: a PI is at its hash or in one of the entries after it.
+// ***** PRIVATE *****
+byte Si4735::eon_entry(word programId){
+   byte start = eon_hash(programId);
+   byte index = start;
+   for(byte n=0; n<Si47xx_RDS_EON; n++){
+      if(eon[index].programId==programId) return index;
+      if(!eon[index].programId) break;
+      index = (index+1) & (Si47xx_RDS_EON-1);
+   }
+   //Table full - replace entry at hash
+   if(eon[index].programId) index=start;
+   EONStation *station=&eon[index];
+   station->programId=programId;
+   memset(station->programService, ' ', sizeof(station->programService)-1);
+   station->programService[sizeof(station->programService)-1]='\0';
+   station->programType=0;
+   station->trafficProgram=unknown;
+   station->trafficAlert=unknown;
+   memset(station->frequencies, 0, sizeof(station->frequencies));
+   return index;
+}
+
+const EONStation *Si4735::findEON(word programId){
+   if(!programId) return 0;
+   byte index = eon_hash(programId);
+   for(byte n=0; n<Si47xx_RDS_EON; n++){
+      if(eon[index].programId==programId) return &eon[index];
+      if(!eon[index].programId) break;
+      index = (index+1) & (Si47xx_RDS_EON-1);
+   }
+   return 0;
+}
+
+const EONStation *Si4735::findEONTrafficAlert(){
+   for(byte i=0; i<Si47xx_RDS_EON; i++){
+      if(eon[i].programId && eon[i].trafficProgram==true && eon[i].trafficAlert==true) return &eon[i];
+   }
+   return 0;
+}
+#endif
+
+// Library's RDS group handlers, indexed by type<<1 | version.  0 means group is ignored.
+const RDSGroupHandler Si4735::rds_default_handlers[RDS_GROUP_TYPES] PROGMEM = {
+   rds_group_0,     rds_group_0,    //0A, 0B
+   rds_group_1A,    0,              //1A, 1B
+   rds_group_2,     rds_group_2,    //2A, 2B
+   RDS_GROUP_3A,    0,              //3A, 3B
+   rds_group_4A,    0,              //4A, 4B
+   0,               0,              //5A, 5B
+   0,               0,              //6A, 6B
+   0,               0,              //7A, 7B
+   RDS_GROUP_8A,    0,              //8A, 8B
+   0,               0,              //9A, 9B
+   rds_group_10A,   0,              //10A, 10B
+   0,               0,              //11A, 11B
+   0,               0,              //12A, 12B
+   0,               0,              //13A, 13B
+   RDS_GROUP_14,    RDS_GROUP_14,   //14A, 14B
+   0,               rds_group_0     //15A, 15B
+};
+
 // Same as readRDS() but first checks RDS interrupt before trying to get data.
 bool Si4735::checkRDS(){
    //Check if radio has new RDS data for us
@@ -307,6 +1408,17 @@ bool Si4735::checkRDS(){
    return false;
 }
 
+bool Si4735::isProgramIdTrusted(){
+   return _confidence[CONF_PI]>=RDS_THRESHOLD;
+}
+
+bool Si4735::isProgramServiceTrusted(){
+   for(byte segment=0; segment<4; segment++){
+      if(_confidence[CONF_PS+segment]<RDS_THRESHOLD) return false;
+   }
+   return true;
+}
+
 // Saves the call sign derived from the RBDS PI code in the given 5 char buffer.
 // Returns true if buffer has a valid call sign.  Otherwise, returns false and
 // the buffer is initialized with fill chars.  If PI is invalid, a '-' is used.
@@ -515,8 +1627,8 @@ bool Si4735::getCallSign(char callSign[5]){
  */
 // ***** PRIVATE *****
 bool Si4735::check_if_RBDS(){
-   //XXX Check Extended Country Code (ECC) if ECC saved is trustworthy
-   if(_extendedCountryCode_count < RDS_THRESHOLD){
+   //Check Extended Country Code (ECC) if ECC saved is trustworthy
+   if(_confidence[CONF_ECC] < RDS_THRESHOLD){
       goto no_ecc;
    }
    switch(rds.extendedCountryCode){
@@ -756,3 +1868,4 @@ bool Si4735::getLocalTime(Time *time){
    return true;
 }
 
+#endif
@@ -39,11 +39,6 @@
  */
 
 #include "Si4735.h"
-#ifdef Si47xx_SPI
- #include "SPI.h"
-#else
- #include "Wire.h"
-#endif
 #include <string.h>
 
 // Arguments for tune_status().
@@ -60,13 +55,92 @@ enum {
    SEEK_START_DOWN = SEEK_START_ARG1_WRAP
 };
 
+// Bus used to talk to radio.  With Si47xx_STATIC_BUS the default bus's methods are
+// called directly so the compiler can inline them.
+#ifdef Si47xx_STATIC_BUS
+ #define RADIO_BUS(call) radioBus.Si47xxDefaultBus::call
+#else
+ #define RADIO_BUS(call) _bus->call
+#endif
+
+#ifdef Si47xx_BUS_STATS
+// Count command in bus statistics.
+static void count_command(BusStats *stats, byte opcode){
+   byte i;
+   for(i=0; i<stats->opcodes; i++){
+      if(stats->commands[i].opcode==opcode) break;
+   }
+   if(i==stats->opcodes){
+      //New opcode
+      if(i>=Si47xx_BUS_STATS){
+         ++stats->otherCommands;
+         return;
+      }
+      stats->commands[i].opcode=opcode;
+      stats->commands[i].count=0;
+      ++stats->opcodes;
+   }
+   ++stats->commands[i].count;
+}
+
+// Count wait in histogram whose first bucket holds waits shorter than limit.
+static void count_wait(unsigned long *histogram, unsigned long time, unsigned long limit){
+   byte i=0;
+   while(i<BUS_HISTOGRAM_BUCKETS-1 && time>=limit){
+      limit<<=1;
+      ++i;
+   }
+   ++histogram[i];
+}
+#endif
+
+#if Si47xx_PROPERTY_CACHE
+// Radio's default values for properties set by this library.  See "Si47xx Programming Guide".
+// After POWER_UP, setProperty() does not need to send these values to the radio.
+static const PropertyValue PROGMEM property_defaults[]={
+   {PROP_GPO_IEN,              0x0000},
+   {PROP_RX_VOLUME,            MAX_VOLUME},
+   {PROP_RX_HARD_MUTE,         0x0000},
+   {PROP_FM_DEEMPHASIS,        FM_DEEMPHASIS_ARG_75},
+   {PROP_FM_SEEK_BAND_BOTTOM,  8750},  //87.5 MHz
+   {PROP_FM_SEEK_BAND_TOP,     10790}, //107.9 MHz
+   {PROP_FM_SEEK_FREQ_SPACING, 10},    //100 kHz
+   {PROP_FM_RDS_INT_SOURCE,    0x0000},
+   {PROP_FM_RDS_INT_FIFO_COUNT,0x0000},
+   {PROP_FM_RDS_CONFIG,        0x0000},
+   {PROP_AM_DEEMPHASIS,        0x0000},
+   {PROP_AM_SEEK_BAND_BOTTOM,  520},   //kHz
+   {PROP_AM_SEEK_BAND_TOP,     1710},  //kHz
+   {PROP_AM_SEEK_FREQ_SPACING, 10},    //kHz
+};
+enum {NUM_PROPERTY_DEFAULTS=sizeof(property_defaults)/sizeof(PropertyValue)};
+// Each default has one bit in the word _at_default.  Compile fails if there are too many.
+typedef char property_defaults_fit_at_default[NUM_PROPERTY_DEFAULTS<=16 ? 1 : -1];
+
+// Returns bit for given property in _at_default.  Returns 0 if property has no known default.
+static word default_bit(word property){
+   for(byte i=0; i<NUM_PROPERTY_DEFAULTS; i++){
+      if(pgm_read_word(&property_defaults[i].property)==property) return 1U<<i;
+   }
+   return 0;
+}
+#endif
+
 /******************************************************************************
 *   Initialization                                                            *
 ******************************************************************************/
 
 // The Si4735 class constructor to initialize a new object.
-Si4735::Si4735(){
+// If no bus is given, the default SPI or I2C bus is used.
+Si4735::Si4735(Si47xxBus *bus){
    //Init variables
+ #ifdef Si47xx_STATIC_BUS
+   (void)bus;                  //Always uses radioBus
+ #elif defined(ARDUINO)
+   _bus        = bus ? bus : &radioBus;
+ #else
+   _bus        = bus;          //Host computer: Caller must supply bus
+ #endif
    _frequency  = 0;            //No frequency tuned
    _mode       = RADIO_OFF;    //Radio is initially off
    _region     = REGION_2_NA;  //Default to ITU Region 2, subregion North America
@@ -74,7 +148,54 @@ Si4735::Si4735(){
    _volume     = MAX_VOLUME;   //Default to max volume
    _mute       = false;        //Default to mute off
    _interrupts = CTS_MASK;     //Radio's default interrupts
+ #ifndef Si47xx_AM_ONLY
+   _rds_batch  = 0;            //Radio's default RDS interrupt: every group
+ #ifdef Si47xx_RDS_UTF8
+   _utf8_text  = 0;            //getRadioTextUTF8() not called yet
+ #endif
+ #ifdef Si47xx_RDS_CAPTURE
+   _rds_sink   = 0;            //RDS capture off
+ #endif
+ #endif
+ #ifdef Si47xx_COMMAND_QUEUE
+   _queue_head  = 0;           //Command queue is empty
+   _queue_count = 0;
+   _queue_active= false;
+ #endif
+ #ifdef Si47xx_INTERRUPT_HANDLERS
+   _handler_count= 0;          //No interrupt handlers
+   _error_pending= false;
+ #endif
+ #ifdef Si47xx_RDS_HANDLERS
+   //Start with library's RDS decoders
+   memcpy_P(_rds_handlers, rds_default_handlers, sizeof(_rds_handlers));
+ #endif
+ #if Si47xx_PROPERTY_CACHE
+   _cache_hits  = 0;
+   _cache_misses= 0;
+   clearPropertyCache();
+ #endif
+ #ifdef Si47xx_RDS_CACHE
+   _rds_cache_count=0;         //No stations remembered
+ #endif
+ #ifdef Si47xx_BUS_STATS
+   clearBusStats();
+ #endif
+ #ifdef Si47xx_RDS_AF
+   //No AF list, AF following off
+   afList.programId=0;
+   afList.count=0;
+   _af_min_rssi=_af_min_snr=0;
+   _af_searching=false;
+   _af_hold=false;
+ #endif
+ #ifndef Si47xx_AM_ONLY
+   //Make sure end of string buffers are null terminated
+   rds.programService[sizeof(rds.programService)-1]='\0';
+   rds.radioText[sizeof(rds.radioText)-1]='\0';
+   rds.programTypeName[sizeof(rds.programTypeName)-1]='\0';
    clearStationInfo();
+ #endif
    //Clear revision info
    revision.partNumber    =0xFF;
    revision.firmwareMajor ='\0';
@@ -82,14 +203,13 @@ Si4735::Si4735(){
    revision.componentMajor='\0';
    revision.componentMinor='\0';
    revision.chip          ='\0';
-   //Make sure end of string buffers are null terminated
-   rds.programService[sizeof(rds.programService)-1]='\0';
-   rds.radioText[sizeof(rds.radioText)-1]='\0';
-   rds.programTypeName[sizeof(rds.programTypeName)-1]='\0';
 }
 
 // Clear RDS station info.
 void Si4735::clearStationInfo(){
+ #ifndef Si47xx_AM_ONLY
+   //Nothing received yet
+   memset(_confidence, 0, sizeof(_confidence));
    //Clear info
    rds.programId=0;  //Unknown station
    rds.RDSSignal=false;  //RDS signal not yet detected
@@ -109,134 +229,73 @@ void Si4735::clearStationInfo(){
    rds.offset         =NO_DATE_TIME;  //No date/time yet received
    _abRadioText       =unknown;
    _abProgramTypeName =unknown;
-   _extendedCountryCode_count=0;
-   _language_count           =0;
+ #ifdef Si47xx_RDS_BUFFER
+   //Forget groups from previous station
+   _rds_head=0;
+   _rds_count=0;
+ #endif
    //Clear strings
    for(byte i=0; i<sizeof(rds.programService)-1; i++) rds.programService[i]=' ';
    rds.radioText[0]='\0';
    rds.radioTextLen=0;  //Radio Text not yet received
    rds.programTypeName[0]='\0';
+ #ifdef Si47xx_RDS_RTPLUS
+   rtPlus.group=RTPLUS_NO_GROUP;
+   rtPlus.running=false;
+   rtPlus.toggle=unknown;
+   memset(rtPlus.tags, 0, sizeof(rtPlus.tags));
+   rtPlus.title[0]=rtPlus.artist[0]=rtPlus.album[0]='\0';
+   _rtplus_changes=RTPLUS_CHANGED_TITLE | RTPLUS_CHANGED_ARTIST | RTPLUS_CHANGED_ALBUM | RTPLUS_CHANGED_RUNNING;
+ #endif
+ #ifdef Si47xx_RDS_ERT
+   ert.group=ODA_NO_GROUP;
+   ert.utf8=false;
+   ert.rightToLeft=false;
+   ert.length=0;
+   memset(ert.text, 0, sizeof(ert.text));
+ #endif
+ #ifdef Si47xx_RDS_TMC
+   //Events belong to old station's location table
+   _tmc_head=0;
+   _tmc_count=0;
+   memset(_tmc_seen, 0, sizeof(_tmc_seen));
+   _tmc_ci=0xFF;
+ #endif
+ #ifdef Si47xx_RDS_CACHE
+   _rds_cached_pi=0;
+ #endif
+ #ifdef Si47xx_RDS_EON
+   //Other networks of old station
+   for(byte i=0; i<Si47xx_RDS_EON; i++) eon[i].programId=0;
+ #endif
+ #ifdef Si47xx_RDS_AF
+   //afList is kept.  It is replaced when a station with another PI is received.
+   _af_header=0;
+   _af_lfmf=false;
+ #endif
+ #ifdef Si47xx_RDS_UTF8
+   _utf8_dirty=0xFFFF;
+ #endif
+ #ifdef Si47xx_RDS_STABLE
+   rdsStable=rds;
+   _rds_changes=RDS_CHANGED_ALL;
+ #endif
+ #endif
 }
 
-#ifndef __AVR__
-// Interrupt flag
-static volatile bool interrupt_signal=false;
-
-// Interrupt handler for ARM based Arduinos.
-static void interrupt_handler(){
-   //Tell currentInterrupts() that interrupt signal received from radio
-   interrupt_signal=true;
-}
-#endif
-
 // Applies power to and resets the radio.  Initializes interrupts.
 // If option BEGIN_DO_NOT_INIT_BUS is given, the SPI or I2C bus is NOT initialized.
-// See sections 6 "Control Interface" and 7 "Powerup" in Si47xx Programming Guide
-// and Table 4 "Reset Timing Characteristics" in Si4734/35-C40 data sheet.
+// See Si47xxBus.cpp for details.
 void Si4735::begin(byte options, byte bus_arg){
- #ifdef Si47xx_SPI
-
-   //Configure the SPI hardware
-   digitalWrite(RADIO_SPI_SS_PIN, HIGH);
-   pinMode(RADIO_SPI_SS_PIN, OUTPUT);
-   //Init SPI, if requested
-   if( !(options & BEGIN_DO_NOT_INIT_BUS) ){
-      SPI.begin();
-      //Note: Max speed of Si4735 clock input is 2.5 MHz.
-      SPI.setClockDivider(bus_arg ? bus_arg : RADIO_SPI_CLOCK_DIV);
-   }
-
- #else
-
-   //Init I2C, if requested
-   //Note: I2C's SCLK must be initialized (that is, high) before reset goes high below.
-   if( !(options & BEGIN_DO_NOT_INIT_BUS) ){
-      Wire.begin();
-   }
-   //Save radio's address
-   _address = bus_arg ? bus_arg : RADIO_I2C_ADDRESS;
-
- #endif
-
-   pinMode(RADIO_POWER_PIN, OUTPUT);
-   pinMode(RADIO_RESET_PIN, OUTPUT);
-   //Hard reset radio
-   digitalWrite(RADIO_RESET_PIN, LOW);
-   //At this point, power may be on or off, depending on when we are called.
-   //Remove power from radio
-   digitalWrite(RADIO_POWER_PIN, LOW);
- #if 00  // <---Kill driving RADIO_INT_PIN
-   //DANGER: We cannot output a high signal on the RADIO_INT_PIN if a unidirectional
-   //level shifter is used on the INT pin.  Breakout board users should use a 10 kΩ
-   //pull-up resistor (to 3.3V) to select SPI, just like the shield does.
- #ifdef Si47xx_SPI
-   //Tell radio to use SPI mode.  INT pin is read by radio when RESET pin rises.
-   //Note: The SparkFun Arduino shield already provides a 10 kΩ pull-up resistor
-   //on the GPO2/INT pin, which makes this step unnecessary for the shield.
-   //Driving this pin is only useful for breakout board users who are using a
-   //bidirectional level shifter or do not need a level shifter.
-   pinMode(RADIO_INT_PIN, OUTPUT);
-   digitalWrite(RADIO_INT_PIN, HIGH);
- #endif
- #endif
-   //Give chip a chance to fully power down
-   //Note: We wait here because we have removed power from the chip, it takes
-   //time to discharge the capacitors connected to the radio's power pins, and
-   //circuits don't like it when their power supply makes rapid changes.
-   delay(1);
-   //Note: Reset must be low while applying power.
-   //Apply power to radio
-   digitalWrite(RADIO_POWER_PIN, HIGH);
-   //Note: Power must be stable for 250 µs before releasing reset.
-   //Note: We wait 50 µs longer because capacitors connected to the radio's power
-   //pins take time to charge and also for safety.
-   //Note: Setup time for GPO1 & GPO2 before reset goes high to select the radio's
-   //bus mode is 100 µs.  However, this is less than the 250 µs we must wait anyways.
-   //Note: There may not be any I2C or SPI bus traffic 300 ns before reset goes high.
-   //Wait 250 µs between applying power and releasing reset.
-   delayMicroseconds(250+50);  //Chip requires 250 µs, extra 50 µs for safety
-   //Release reset - radio now does its internal cold power up initialization
-   digitalWrite(RADIO_RESET_PIN, HIGH);
-   //Give chip time to start-up
-   //Note: The hold time for GPO1 & GPO2 after reset goes high is 30 ns.
-   //Note: The data sheet and guide do not indicate a need to wait before receiving
-   //the first command.  However, it's better to wait just a little.
-   delay(1);
+   //Initialize bus and reset radio
+   RADIO_BUS(begin(options, bus_arg));
    //After hardware reset, radio is in low-power "off" state
    _mode = RADIO_OFF;
    //Radio's default interrupts
    _interrupts = CTS_MASK;
-
-   //Initialize interrupt pin for normal usage with internal pull-up resistor on.
-   //By having the pull-up resistor active, we prevent spurious interrupts if the user
-   //has chosen not to connect the radio's interrupt output to the microcontroller's
-   //interrupt input.
-   #if ARDUINO >= 101
-   pinMode(RADIO_INT_PIN, INPUT_PULLUP);
-   #else
-   pinMode(RADIO_INT_PIN, INPUT);
-   digitalWrite(RADIO_INT_PIN, HIGH);
-   #endif
-   //Set external interrupt's mode to trigger on trailing edge of interrupt pulse.
-   /* It is possible for two or more interrupts to occur at about the same time,
-    * resulting in only one detectable pulse.  To make certain that we get all the
-    * interrupt sources that caused the pulse, we trigger at the end (or rising edge)
-    * of the active-low pulse.
-    */
- #ifdef __AVR__
-   /* AVR based Arduinos */
-   if(RADIO_EXT_INT<4){
-      EICRA |= RISING<<(RADIO_EXT_INT*2);
-   }else{
-      //Check for Mega or Leonardo
-      #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__) || defined(__AVR_ATmega32U4__)
-      EICRB |= RISING<<((RADIO_EXT_INT-4)*2);
-      #endif
-   }
- #else
-   /* ARM based Arduinos - does not use RADIO_EXT_INT */
-   //Install interrupt handler
-   attachInterrupt(RADIO_INT_PIN, interrupt_handler, RISING);
+ #if Si47xx_PROPERTY_CACHE
+   //Radio's properties are back to their defaults
+   clearPropertyCache();
  #endif
 }
 
@@ -248,12 +307,7 @@ void Si4735::end(){
    //Therefore, we first send a POWER_DOWN command via setMode().
    setMode(RADIO_OFF);
    //Remove power from radio
-   digitalWrite(RADIO_POWER_PIN, LOW);
- #ifndef __AVR__
-   /* ARM based Arduinos */
-   //Remove interrupt handler
-   detachInterrupt(RADIO_INT_PIN);
- #endif
+   RADIO_BUS(end());
 }
 
 // Return radio's current mode
@@ -267,6 +321,13 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
    //If mode is not changing, do nothing and return
    byte old_mode=_mode;
    if(new_mode==old_mode) return;
+ #ifdef Si47xx_FM_ONLY
+   //AM bands not compiled in
+   if(new_mode!=FM && new_mode!=RADIO_OFF) return;
+ #elif defined(Si47xx_AM_ONLY)
+   //FM not compiled in
+   if(new_mode==FM) return;
+ #endif
 
    //Set radio's new mode
    _mode = new_mode;
@@ -312,7 +373,7 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
       }
       //Build POWER_UP command
       _buffer[0] = CMD_POWER_UP;
-      if(new_mode==FM){
+      if(fm_band(new_mode)){
          arg1 |= POWER_UP_ARG1_FUNC_FM;
       }else{  //AM, SW, LW
          arg1 |= POWER_UP_ARG1_FUNC_AM;
@@ -332,7 +393,7 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
 
       //Enable interrupts for RDS (FM only), STC, and RSQ
       word int_mask;  //Interrupts to enable
-      if(new_mode==FM && rds){
+      if(fm_band(new_mode) && rds){
          int_mask = STC_MASK | RSQ_MASK | RDS_MASK;
       }else{  //AM, SW, LW, and FM without RDS
          int_mask = STC_MASK | RSQ_MASK;
@@ -356,7 +417,7 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
 
       //Do mode specific initialization
       word bottom, top, spacing;  //Band limits and spacing
-      if(new_mode==FM){
+      if(fm_band(new_mode)){
          //All current Si47xx chips with a "D60" suffix have a firmware bug in FM mode
          //which causes noise in the audio output.  Set hidden property to correct bug.
          //See "Si47xx Programming Guide," rev 0.8, Appendix B "Si4704/05/3x-B20/-C40/-D60
@@ -365,22 +426,29 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
             setProperty(0xFF00, 0);
          }
 
+       #ifndef Si47xx_AM_ONLY
          if(rds){
-            //Enable RDS
-            /* The A block always contains the same data (PI) and is not required to
-             * decode the rest of the group.  Therefore, we permit it to be damaged.
-             * Other blocks must be received perfectly or be correctable.
-             */
-            setProperty(PROP_FM_RDS_CONFIG, (FM_RDS_CONFIG_ARG_ENABLE |
-             FM_RDS_CONFIG_ARG_BLOCK_A_UNCORRECTABLE |
-             FM_RDS_CONFIG_ARG_BLOCK_B_5_BIT_ERRORS |
-             FM_RDS_CONFIG_ARG_BLOCK_C_5_BIT_ERRORS |
-             FM_RDS_CONFIG_ARG_BLOCK_D_5_BIT_ERRORS) );
-            //Enable RDS interrupt sources
-            //Generate interrupt when new data arrives and when RDS sync is gained or lost.
-            setProperty(PROP_FM_RDS_INT_SOURCE, (RDS_RECEIVED_MASK |
-             RDS_SYNC_FOUND_MASK | RDS_SYNC_LOST_MASK) );
+            static const PropertyValue PROGMEM FM_RDS_PROPERTIES[]={
+               //Enable RDS
+               /* The A block always contains the same data (PI) and is not required to
+                * decode the rest of the group.  Therefore, we permit it to be damaged.
+                * Other blocks must be received perfectly or be correctable.
+                */
+               {PROP_FM_RDS_CONFIG, (FM_RDS_CONFIG_ARG_ENABLE |
+                FM_RDS_CONFIG_ARG_BLOCK_A_UNCORRECTABLE |
+                FM_RDS_CONFIG_ARG_BLOCK_B_5_BIT_ERRORS |
+                FM_RDS_CONFIG_ARG_BLOCK_C_5_BIT_ERRORS |
+                FM_RDS_CONFIG_ARG_BLOCK_D_5_BIT_ERRORS)},
+               //Enable RDS interrupt sources
+               //Generate interrupt when new data arrives and when RDS sync is gained or lost.
+               {PROP_FM_RDS_INT_SOURCE, (RDS_RECEIVED_MASK |
+                RDS_SYNC_FOUND_MASK | RDS_SYNC_LOST_MASK)}
+            };
+            applyProperties_P(FM_RDS_PROPERTIES, sizeof(FM_RDS_PROPERTIES)/sizeof(PropertyValue));
+            //Number of groups per RDS interrupt
+            setProperty(PROP_FM_RDS_INT_FIFO_COUNT, _rds_batch);
          }
+       #endif
 
          /* Manual gives maximum FM range of radio as 64-108 MHz.
           * Radio chip defaults to 87.5-107.9 MHz, 100 kHz spacing.
@@ -429,11 +497,16 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
             spacing = 10;  //100 kHz
          }
          //Setup FM band and spacing
-         setProperty(PROP_FM_SEEK_BAND_BOTTOM, bottom);
-         setProperty(PROP_FM_SEEK_BAND_TOP, top);
-         setProperty(PROP_FM_SEEK_FREQ_SPACING, spacing);
+         //Note: applyProperties() skips properties already at the radio's default values.
+         PropertyValue band[]={
+            {PROP_FM_SEEK_BAND_BOTTOM, bottom},
+            {PROP_FM_SEEK_BAND_TOP, top},
+            {PROP_FM_SEEK_FREQ_SPACING, spacing}
+         };
+         applyProperties(band, sizeof(band)/sizeof(PropertyValue));
          //North America and South Korea use default FM de-emphasis of 75 μs.
-         //All others use 50 μs.
+         //All others use 50 μs.  FM mode always starts with POWER_UP, so 75 μs is
+         //already set.
          if(_region!=REGION_2_NA && _locale!=LOCALE_KR){
             setProperty(PROP_FM_DEEMPHASIS, FM_DEEMPHASIS_ARG_50);
          }
@@ -502,11 +575,17 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
                spacing = 1;
             }
             break;
+         default:
+            //Not reached: new_mode was checked above
+            return;
          }
          //Setup AM band and spacing
-         setProperty(PROP_AM_SEEK_BAND_BOTTOM, bottom);
-         setProperty(PROP_AM_SEEK_BAND_TOP, top);
-         setProperty(PROP_AM_SEEK_FREQ_SPACING, spacing);
+         PropertyValue band[]={
+            {PROP_AM_SEEK_BAND_BOTTOM, bottom},
+            {PROP_AM_SEEK_BAND_TOP, top},
+            {PROP_AM_SEEK_FREQ_SPACING, spacing}
+         };
+         applyProperties(band, sizeof(band)/sizeof(PropertyValue));
       }
       //Save band and spacing
       _bottom=bottom;
@@ -520,7 +599,7 @@ void Si4735::setMode(byte new_mode, byte options, byte audio_mode){
 // Set top of receive band.
 void Si4735::setBandTop(word top){
    _top=top;
-   if(_mode==FM){
+   if(fm_band(_mode)){
       setProperty(PROP_FM_SEEK_BAND_TOP, top);
    }else{  //AM, SW, LW
       setProperty(PROP_AM_SEEK_BAND_TOP, top);
@@ -530,7 +609,7 @@ void Si4735::setBandTop(word top){
 // Set bottom of receive band.
 void Si4735::setBandBottom(word bottom){
    _bottom=bottom;
-   if(_mode==FM){
+   if(fm_band(_mode)){
       setProperty(PROP_FM_SEEK_BAND_BOTTOM, bottom);
    }else{  //AM, SW, LW
       setProperty(PROP_AM_SEEK_BAND_BOTTOM, bottom);
@@ -540,7 +619,7 @@ void Si4735::setBandBottom(word bottom){
 // Set frequency spacing.
 void Si4735::setSpacing(word spacing){
    _spacing=spacing;
-   if(_mode==FM){
+   if(fm_band(_mode)){
       setProperty(PROP_FM_SEEK_FREQ_SPACING, spacing);
    }else{  //AM, SW, LW
       setProperty(PROP_AM_SEEK_FREQ_SPACING, spacing);
@@ -589,6 +668,16 @@ byte Si4735::getLocale(){
 // this library more flexible when used with boards not using the Si4735's internal
 // oscillator.  In this case, bus traffic while tuning is OK.
 void Si4735::tuneFrequency(word frequency){
+   tune_frequency(frequency, 0);
+}
+
+// Do TUNE_FREQ command with given ARG1.
+// ***** PRIVATE *****
+void Si4735::tune_frequency(word frequency, byte arg, bool new_station){
+ #ifdef Si47xx_RDS_CACHE
+   //Remember station being left
+   if(new_station) rds_cache_save();
+ #endif
    //Force new frequency into current band
    frequency=constrain(frequency, _bottom, _top);
    //Save new frequency
@@ -600,32 +689,33 @@ void Si4735::tuneFrequency(word frequency){
    //Depending on the current mode, set the new frequency (TUNE_FREQ) (and clear STC interrupt).
    //Build command
    _buffer[0]=CMD_AM_TUNE_FREQ;
-   _buffer[1]=0x00;
+   _buffer[1]=arg;
    _buffer[2]=highByte;
    _buffer[3]=lowByte;
    _buffer[4]=0x00;
    _buffer[5]=0x00;  //Note: ARG5 ignored by FM_TUNE_FREQ
-   switch(_mode){
-   case FM:
+   if(fm_band(_mode)){
       _buffer[0]=CMD_FM_TUNE_FREQ;
-      break;
-   case SW:
+   }else if(_mode==SW){
       _buffer[5]=0x01;
-      break;
    }
    //Send TUNE_FREQ command
    sendCommand(_buffer, 6);
 
    //Clear local STC interrupt and RDS info
    clearInterrupts(STC_MASK);
+   if(!new_station) return;
    clearStationInfo();
+ #ifdef Si47xx_RDS_CACHE
+   rds_cache_restore();
+ #endif
 }
 
 // Set radio's frequency and then wait for tuning to complete.  Frequency is measured
 // in kHz for AM, SW, LW and in 10 kHz increments for FM.
-void Si4735::tuneFrequencyAndWait(word frequency){
+byte Si4735::tuneFrequencyAndWait(word frequency, IdleCallback idle){
    tuneFrequency(frequency);
-   waitSTC();
+   return waitSTC(RADIO_TUNE_TIMEOUT, idle);
 }
 
 // Increments the currently tuned frequency.  The new frequency wraps to the bottom
@@ -675,11 +765,11 @@ word Si4735::frequencyDown(void){
 // Increments the currently tuned frequency and then waits for tuning to complete.
 // The new frequency wraps to the bottom if it would exceed the top of band.
 // Returns the newly tuned frequency.
-word Si4735::frequencyUpAndWait(void){
+word Si4735::frequencyUpAndWait(IdleCallback idle){
    //Increment frequency
    frequencyUp();
    //Wait until STC received
-   waitSTC();
+   if(waitSTC(RADIO_TUNE_TIMEOUT, idle)!=RADIO_OK) return 0;
    //Return new frequency
    return _frequency;
 }
@@ -687,24 +777,59 @@ word Si4735::frequencyUpAndWait(void){
 // Decrements the currently tuned frequency and then waits for tuning to complete.
 // The new frequency wraps to the top if it would exceed the bottom of band.
 // Returns the newly tuned frequency.
-word Si4735::frequencyDownAndWait(void){
+word Si4735::frequencyDownAndWait(IdleCallback idle){
    //Decrement frequency
    frequencyDown();
    //Wait until STC received
-   waitSTC();
+   if(waitSTC(RADIO_TUNE_TIMEOUT, idle)!=RADIO_OK) return 0;
    //Return new frequency
    return _frequency;
 }
 
-// Wait for Seek/Tune Complete (STC).
-void Si4735::waitSTC(){
+// Wait for Seek/Tune Complete (STC).  Calls idle callback while waiting.
+// Returns RADIO_OK, RADIO_TIMEOUT, or RADIO_ERROR.
+byte Si4735::waitSTC(word timeout, IdleCallback idle){
+   unsigned long start=millis();
+   byte result=RADIO_OK;
    //Wait until STC received
-   while( !(currentInterrupts() & STC_MASK) );
+   while( !(_interrupts & STC_MASK) ){
+      //Check for interrupt signal
+      if(RADIO_BUS(interruptReceived())){
+         if(read_interrupts()!=RADIO_OK){
+            result=RADIO_ERROR;
+            break;
+         }
+         continue;
+      }
+      //Check timeout
+      if(millis()-start >= timeout){
+         //Interrupt signal may have been lost.  Ask radio one last time.
+         if(read_interrupts()!=RADIO_OK){
+            result=RADIO_ERROR;
+         }else if(!(_interrupts & STC_MASK)){
+            result=RADIO_TIMEOUT;
+         }
+         break;
+      }
+      //Let caller do something useful
+      if(idle) idle();
+   }
+ #ifdef Si47xx_BUS_STATS
+   unsigned long elapsed=millis()-start;
+   ++busStats.stcWaits;
+   busStats.stcMillis+=elapsed;
+   count_wait(busStats.stcHistogram, elapsed, BUS_STC_BUCKET_MS);
+ #endif
+   return result;
 }
 
 // Do SEEK_START command.
 // ***** PRIVATE *****
 void Si4735::seek_start(byte arg){
+ #ifdef Si47xx_RDS_CACHE
+   //Remember station being left
+   rds_cache_save();
+ #endif
    //Build command
    _buffer[0]=CMD_AM_SEEK_START;
    _buffer[1]=arg;
@@ -712,13 +837,10 @@ void Si4735::seek_start(byte arg){
    _buffer[3]=0x00;
    _buffer[4]=0x00;
    _buffer[5]=0x00;
-   switch(_mode){
-   case FM:
+   if(fm_band(_mode)){
       _buffer[0]=CMD_FM_SEEK_START;
-      break;
-   case SW:
+   }else if(_mode==SW){
       _buffer[5]=0x01;
-      break;
    }
    //Send SEEK_START command
    sendCommand(_buffer, 6);
@@ -745,7 +867,7 @@ void Si4735::seekDown(){
 // ***** PRIVATE *****
 word Si4735::tune_status(byte arg){
    //Set TUNE_STATUS command
-   if(_mode==FM){
+   if(fm_band(_mode)){
       _buffer[0]=CMD_FM_TUNE_STATUS;
    }else{  //AM, SW, LW
       _buffer[0]=CMD_AM_TUNE_STATUS;
@@ -767,6 +889,53 @@ word Si4735::tune_status(byte arg){
    return _frequency;
 }
 
+// Scan band and save valid stations in given array.  Returns number of stations saved.
+byte Si4735::scanBand(StationRecord *stations, byte max_stations, byte strategy,
+ unsigned long *time, IdleCallback idle){
+   unsigned long start=millis();
+   word previous=_frequency;  //Tuned frequency before scan
+   byte count=0;  //Stations saved
+   if(_mode==RADIO_OFF) max_stations=0;
+   //Start at bottom of band.  Seek only checks channels after the current one.
+   byte arg = strategy==SCAN_STEP_FAST ? TUNE_FREQ_ARG1_FAST : 0;
+   word channel=_bottom;  //Channel being checked
+   word timeout=RADIO_TUNE_TIMEOUT;
+   if(max_stations) tune_frequency(channel, arg);
+   while(count<max_stations){
+      //Wait for tune or seek to finish
+      if(waitSTC(timeout, idle)!=RADIO_OK) break;
+      word frequency=tune_status(TUNE_STATUS_CLEAR_STC);
+      byte resp1=_buffer[1];
+      //Only read RSQ for valid stations.  A seek that hits the top of the band
+      //may stop on the station found by the previous seek.
+      if((resp1 & FIELD_TUNE_STATUS_RESP1_VALID) &&
+       (!count || frequency!=stations[count-1].frequency)){
+         RSQMetrics RSQ;
+         getRSQ(&RSQ);
+         stations[count].frequency=frequency;
+         stations[count].RSSI=RSQ.RSSI;
+         stations[count].SNR=RSQ.SNR;
+         stations[count].multipath=RSQ.multipath;
+         ++count;
+      }
+      //Go to next channel
+      if(strategy==SCAN_SEEK){
+         //Stop at top of band
+         if(resp1 & FIELD_TUNE_STATUS_RESP1_SEEK_LIMIT) break;
+         seek_start(SEEK_START_ARG1_SEEK_UP);  //No wrap
+         timeout=RADIO_SEEK_TIMEOUT;
+      }else{
+         if(channel > _top-_spacing) break;
+         channel+=_spacing;
+         tune_frequency(channel, arg);
+      }
+   }
+   if(time) *time=millis()-start;
+   //Return to station tuned before scan
+   if(previous) tuneFrequencyAndWait(previous, idle);
+   return count;
+}
+
 // Tell radio to cancel seek operation.  Returns radio's current frequency.
 // Clears STC interrupt.
 word Si4735::cancelSeek(){
@@ -830,7 +999,7 @@ void Si4735::getRSQ(RSQMetrics *RSQ){
    const byte PROGMEM *command;  //Command to send
 
    //Select Received Signal Quality command
-   if(_mode==FM){
+   if(fm_band(_mode)){
       command=FM_RSQ_STATUS;
    }else{  //AM, SW, LW
       command=AM_RSQ_STATUS;
@@ -849,7 +1018,7 @@ void Si4735::getRSQ(RSQMetrics *RSQ){
    RSQ->seekable =_buffer[2] & FIELD_RSQ_STATUS_RESP2_SEEKABLE;
    RSQ->AFCRailed=_buffer[2] & FIELD_RSQ_STATUS_RESP2_AFC_RAILED;
    RSQ->softMute =_buffer[2] & FIELD_RSQ_STATUS_RESP2_SOFT_MUTE;
-   if(_mode==FM){
+   if(fm_band(_mode)){
       RSQ->stereo=_buffer[3] & FIELD_RSQ_STATUS_RESP3_STEREO;
       RSQ->stereoBlend=_buffer[3] & FIELD_RSQ_STATUS_RESP3_STEREO_BLEND;
       RSQ->multipath=_buffer[6];
@@ -956,65 +1125,130 @@ bool Si4735::getMute(){
 *   Send command and get responce or interrupts                               *
 ******************************************************************************/
 
-// Send command packet.  Maximum length is CMD_MAX_LENGTH bytes.
-void Si4735::sendCommand(const byte *command, byte length){
+// Send command packet and wait for CTS.  Maximum length is CMD_MAX_LENGTH bytes.
+// Returns RADIO_OK, RADIO_ERROR, or RADIO_TIMEOUT.
+byte Si4735::sendCommand(const byte *command, byte length){
    debug(print,"Command: ");
    debug(print,*command,HEX);
    debug(print,": ");
    /* Note: We do not need to wait for CTS from the previous command because this
     * method waits below until CTS has occured.
     */
-   //Check if length too long
-   if(length > CMD_MAX_LENGTH) length=CMD_MAX_LENGTH;
-
- #ifdef Si47xx_SPI
-
-   //Select radio on SPI bus.  SS has 15 ns setup time before clock starts.
-   digitalWrite(RADIO_SPI_SS_PIN, LOW);
-
-   //Control byte to write a command
-   SPI.transfer(0x48);
-   //We now send 8 bytes
-   byte i;  //Loop variable
-   for(i=0; i<length; i++) SPI.transfer(command[i]);
-   //Radio requires we write exactly 8 bytes in SPI mode.
-   //Pad the end of packet with 0.
-   for(; i<CMD_MAX_LENGTH; i++) SPI.transfer(0x00);
-
-   //Deselect radio on SPI bus.  SS has 5 ns hold time after clock ends.
-   digitalWrite(RADIO_SPI_SS_PIN, HIGH);
+ #ifdef Si47xx_COMMAND_QUEUE
+   //Finish any queued commands first.  The radio only handles one command at a time.
+   flushCommands();
+ #endif
+   //Send command packet
+   send_packet(command, length);
 
- #else  //I2C
+   //Wait for CTS
+ #ifdef Si47xx_BUS_STATS
+   unsigned long start=micros();
+ #endif
+   byte result=wait_cts(command[0]!=CMD_POWER_UP ? RADIO_CTS_TIMEOUT : RADIO_POWER_UP_CTS_TIMEOUT);
+ #ifdef Si47xx_BUS_STATS
+   unsigned long elapsed=micros()-start;
+   ++busStats.ctsWaits;
+   busStats.ctsMicros+=elapsed;
+   count_wait(busStats.ctsHistogram, elapsed, BUS_CTS_BUCKET_US);
+ #endif
+   track_command(command, result);
+   debug(print,"Command done: ");
+   debug(println,result);
+   return result;
+}
 
-   //Start I2C packet
-   Wire.beginTransmission(_address);
-   //Send command
-   Wire.write(command, length);
-   //Finish I2C packet
-   Wire.endTransmission();
+// Update library's copy of the radio's state after the radio has finished a command.
+// Called for every command, including custom commands sent by the user.
+// ***** PRIVATE *****
+void Si4735::track_command(const byte *command, byte result){
+ #ifdef Si47xx_INTERRUPT_HANDLERS
+   //Tell dispatchInterrupts() to report the error
+   if(result==RADIO_ERROR) _error_pending=true;
+ #endif
+ #if Si47xx_PROPERTY_CACHE
+   switch(command[0]){
+   case CMD_POWER_UP:
+      //Radio resets all properties to their default values
+      clearPropertyCache();
+      if(result==RADIO_OK) _at_default = 0xFFFFU >> (16-NUM_PROPERTY_DEFAULTS);
+      break;
+   case CMD_POWER_DOWN:
+      //Radio's properties are lost
+      clearPropertyCache();
+      break;
+   case CMD_SET_PROPERTY:
+      //Property may no longer have its default value.  The cache now tracks it.
+      _at_default &= ~default_bit(MAKE_WORD(command[2], command[3]));
+      //Remember new value.  If radio rejected the command, forget the old value too.
+      if(result==RADIO_OK){
+         cache_property(MAKE_WORD(command[2], command[3]), MAKE_WORD(command[4], command[5]));
+      }else{
+         byte i=find_property(MAKE_WORD(command[2], command[3]));
+         if(i<_cache_count) _cache[i].property=0;  //0 is never a property we set
+      }
+      break;
+   }
+ #endif
+}
 
+// Write command packet to the radio.  Does not wait for CTS.
+// Maximum length is CMD_MAX_LENGTH bytes.
+// ***** PRIVATE *****
+void Si4735::send_packet(const byte *command, byte length){
+   //Check if length too long
+   if(length > CMD_MAX_LENGTH) length=CMD_MAX_LENGTH;
+ #ifdef Si47xx_BUS_STATS
+   count_command(&busStats, command[0]);
+   busStats.bytesWritten+=length;
  #endif
+   RADIO_BUS(writeCommand(command, length));
+}
+
+// Wait for CTS (Clear To Send) after sending a command.  Timeout is measured in ms.
+// Returns RADIO_OK if CTS received, RADIO_ERROR if the radio also set the ERR bit,
+// or RADIO_TIMEOUT if CTS was not received before the timeout.
+// ***** PRIVATE *****
+byte Si4735::wait_cts(word timeout){
+ #ifdef Si47xx_CTS_DELAY
 
-   //Wait for CTS
    /* All commands take 300 µs for CTS except POWER_UP which takes 110 ms. */
-   if(command[0]!=CMD_POWER_UP){
-      delayMicroseconds(300);
+   if(timeout==RADIO_CTS_TIMEOUT){
+      RADIO_BUS(wait(300));
    }else{
-      delay(110);  //POWER_UP
+      RADIO_BUS(wait(110000UL));  //POWER_UP
    }
-   debug(println,"Command done");
+   return RADIO_OK;
+
+ #else
+
+   //Poll status byte until radio sets CTS.
+   /* Most commands finish long before the 300 µs given by the guide, so the first
+    * status read usually succeeds.  Note: A missing radio or broken bus returns a
+    * status byte of 0xFF on I2C, which is reported as an error.
+    */
+   unsigned long start=millis();
+   do{
+      byte status=getStatus();
+      if(status & CTS_MASK){
+         return (status & ERR_MASK) ? RADIO_ERROR : RADIO_OK;
+      }
+   }while(millis()-start < timeout);
+   return RADIO_TIMEOUT;
+
+ #endif
 }
 
 #ifdef __AVR__
 // Send command packet.  Maximum length is 8 bytes.
 // Command given must be located in flash ROM, not SRAM.  Otherwise, equivalent to sendCommand().
-void Si4735::sendCommand_P(const byte PROGMEM *command_P, byte length){
+byte Si4735::sendCommand_P(const byte PROGMEM *command_P, byte length){
    //Check if length too long for buffer
    if(length > sizeof(_buffer)) length=sizeof(_buffer);
    //Copy flash ROM based command to SRAM
    memcpy_P(_buffer, command_P, length);
    //Send command
-   sendCommand(_buffer, length);
+   return sendCommand(_buffer, length);
 }
 #endif
 
@@ -1022,96 +1256,49 @@ void Si4735::sendCommand_P(const byte PROGMEM *command_P, byte length){
 void Si4735::getResponse(byte *response, byte length){
    debug(print,"Responce: ");
    /* Note: We do not need to wait for CTS because sendCommand() does not return
-    * until CTS has occured.
+    * until CTS has occured (or timed out).
     */
    //Check if length too long
    if(length > RESP_MAX_LENGTH) length=RESP_MAX_LENGTH;
-
- #ifdef Si47xx_SPI
-
-   //Select radio on SPI bus.  SS has 15 ns setup time before clock starts.
-   digitalWrite(RADIO_SPI_SS_PIN, LOW);
-
-   //Control byte to read a long response
-   SPI.transfer(0xE0);
-   //Store response in caller's buffer.
-   byte i;  //Loop variable
-   for(i=0; i<length; i++){
-      response[i] = SPI.transfer(0x00);
-   }
-   //Radio requires that we read exactly 16 bytes in SPI mode.
-   //Throw out remaining bytes.
-   for(; i<RESP_MAX_LENGTH; i++) SPI.transfer(0x00);
-
-   //Deselect radio on SPI bus.  SS has 5 ns hold time after clock ends.
-   digitalWrite(RADIO_SPI_SS_PIN, HIGH);
-
- #else  //I2C
-
-   //Get response
-   byte i = Wire.requestFrom(_address, length);
-   //Store response in caller's buffer.
-   while(i--){
-      *response++ = Wire.read();
-   }
-
+ #ifdef Si47xx_BUS_STATS
+   busStats.bytesRead+=length;
  #endif
+   RADIO_BUS(readResponse(response, length));
 }
 
 // Get single byte status code from radio chip.
 byte Si4735::getStatus(){
-   byte status;  //Status byte from radio
-
- #ifdef Si47xx_SPI
-
-   //Select radio on SPI bus.  SS has 15 ns setup time before clock starts.
-   digitalWrite(RADIO_SPI_SS_PIN, LOW);
-
-   //Control byte to read single byte status code
-   SPI.transfer(0xA0);
-   //Get status byte
-   status = SPI.transfer(0x00);
-
-   //Deselect radio on SPI bus.  SS has 5 ns hold time after clock ends.
-   digitalWrite(RADIO_SPI_SS_PIN, HIGH);
-
- #else  //I2C
-
-   //Get status byte
-   //Note: Wire class has two methodes for requestFrom(), one for byte args and
-   //one for int args.  Call the byte method for efficiency.
-   Wire.requestFrom(_address, byte(1));  //cast into a 'byte' for efficiency
-   status = Wire.read();
-
+ #ifdef Si47xx_BUS_STATS
+   ++busStats.statusReads;
+   ++busStats.bytesRead;
  #endif
-
-   return status;
+   return RADIO_BUS(readStatus());
 }
 
 // Get radio's interrupts by calling GET_INT_STATUS command.
 byte Si4735::getInterrupts(){
+   read_interrupts();
+   //Return interrupts
+   return _interrupts;
+}
+
+// Send GET_INT_STATUS command and save radio's interrupts.
+// Returns RADIO_OK, RADIO_ERROR, or RADIO_TIMEOUT.
+// ***** PRIVATE *****
+byte Si4735::read_interrupts(){
    //Send GET_INT_STATUS command
    static const byte PROGMEM GET_INT_STATUS[]={CMD_GET_INT_STATUS};
-   sendCommand_P(GET_INT_STATUS, sizeof(GET_INT_STATUS));
+   byte result=sendCommand_P(GET_INT_STATUS, sizeof(GET_INT_STATUS));
    //Get new interrupt status
    _interrupts=getStatus();
-   //Return interrupts
-   return _interrupts;
+   return result;
 }
 
 // Returns current interrupt byte.  If an interrupt signal has been received, the new interrupt
 // byte is read and returned.  Otherwise returns previous interrupt byte returned by radio.
 byte Si4735::currentInterrupts(){
    //Check for interrupt signal
- #ifdef __AVR__
-   if(EIFR & (1<<RADIO_EXT_INT)){
-      //Clear AVR's interrupt flag
-      EIFR = 1<<RADIO_EXT_INT;
- #else
-   if(interrupt_signal){
-      //Clear interrupt signal flag
-      interrupt_signal=false;
- #endif
+   if(RADIO_BUS(interruptReceived())){
       //Get new interrupt status
       getInterrupts();
       debug(print,"Int: ");
@@ -1127,8 +1314,77 @@ void Si4735::clearInterrupts(byte interrupt_mask){
    _interrupts &= ~interrupt_mask;
 }
 
+#ifdef Si47xx_INTERRUPT_HANDLERS
+// Register handler for given interrupts.  Replaces mask of handler already registered.
+// A mask of 0 removes the handler.  Returns false if no room for handler.
+bool Si4735::setInterruptHandler(byte mask, InterruptHandler handler){
+   //Look for handler
+   byte i;
+   for(i=0; i<_handler_count; i++){
+      if(_handlers[i].handler==handler) break;
+   }
+   if(!mask){
+      //Remove handler, if found
+      if(i<_handler_count){
+         //Later handlers move down one slot, keeping their order
+         --_handler_count;
+         memmove(&_handlers[i], &_handlers[i]+1, (_handler_count-i)*sizeof(_handlers[0]));
+      }
+      return true;
+   }
+   if(i==_handler_count){
+      //New handler
+      if(_handler_count >= Si47xx_INTERRUPT_HANDLERS) return false;
+      _handlers[i].handler=handler;
+      ++_handler_count;
+   }
+   _handlers[i].mask=mask;
+   return true;
+}
+
+// Read radio's interrupts once per interrupt signal and call all matching handlers.
+// Returns interrupts dispatched.
+byte Si4735::dispatchInterrupts(){
+   byte interrupts=0;
+   //Check for interrupt signal.  One GET_INT_STATUS serves every handler.
+   if(RADIO_BUS(interruptReceived())){
+      interrupts = getInterrupts() & (STC_MASK | RSQ_MASK | RDS_MASK);
+   }
+   //Check for commands rejected by radio
+   if(_error_pending){
+      _error_pending=false;
+      interrupts |= ERR_MASK;
+   }
+   if(!interrupts) return 0;
+   debug(print,"Dispatch: ");
+   debug(println,interrupts,HEX);
+   //Call handlers
+   for(byte i=0; i<_handler_count; ){
+      InterruptHandler handler=_handlers[i].handler;
+      if(_handlers[i].mask & interrupts) handler(interrupts);
+      //A handler may remove itself with setInterruptHandler(0, handler), which moves
+      //the next handler into this slot.  Only step past the handler just called.
+      if(i<_handler_count && _handlers[i].handler==handler) i++;
+   }
+   return interrupts;
+}
+#endif
+
 // Set given property.
 void Si4735::setProperty(word property, word value){
+ #if Si47xx_PROPERTY_CACHE && defined(Si47xx_COMMAND_QUEUE)
+   //Queued commands may change the property.  Finish them before checking the cache.
+   flushCommands();
+ #endif
+ #if Si47xx_PROPERTY_CACHE
+   //Skip bus traffic if radio already has this value
+   word current;
+   if(lookup_property(property, &current) && current==value){
+      ++_cache_hits;
+      return;
+   }
+   ++_cache_misses;
+ #endif
    _buffer[0] = CMD_SET_PROPERTY;
    _buffer[1] = 0;
    //Property to set
@@ -1142,22 +1398,294 @@ void Si4735::setProperty(word property, word value){
 
 // Get given property.
 word Si4735::getProperty(word property){
+   word value;  //Property's value
+ #if Si47xx_PROPERTY_CACHE && defined(Si47xx_COMMAND_QUEUE)
+   //Queued commands may change the property.  Finish them before checking the cache.
+   flushCommands();
+ #endif
+ #if Si47xx_PROPERTY_CACHE
+   //Check for saved copy of property
+   if(lookup_property(property, &value)){
+      ++_cache_hits;
+      return value;
+   }
+   ++_cache_misses;
+ #endif
    _buffer[0] = CMD_GET_PROPERTY;
    _buffer[1] = 0;
    //Property to get
    _buffer[2] = property >> 8;
    _buffer[3] = property;
-   sendCommand(_buffer, 4);
+   byte result=sendCommand(_buffer, 4);
 
    //Get property's value
    getResponse(_buffer, 4);
-   return MAKE_WORD(_buffer[2], _buffer[3]);
+   value=MAKE_WORD(_buffer[2], _buffer[3]);
+ #if Si47xx_PROPERTY_CACHE
+   if(result==RADIO_OK) cache_property(property, value);
+ #else
+   (void)result;
+ #endif
+   return value;
+}
+
+// Set list of properties.  Properties that already have the requested value are skipped.
+void Si4735::applyProperties(const PropertyValue *list, byte count){
+   for(; count; --count, ++list){
+      setProperty(list->property, list->value);
+   }
+}
+
+#ifdef __AVR__
+// Set list of properties.  List must be located in flash ROM, not SRAM.
+// Otherwise, equivalent to applyProperties().
+void Si4735::applyProperties_P(const PropertyValue PROGMEM *list_P, byte count){
+   for(; count; --count, ++list_P){
+      setProperty(pgm_read_word(&list_P->property), pgm_read_word(&list_P->value));
+   }
+}
+#endif
+
+#if Si47xx_PROPERTY_CACHE
+// Forget all saved property values.
+void Si4735::clearPropertyCache(){
+   _cache_count=0;
+   _cache_next=0;
+   _at_default=0;
+}
+
+// Return number of property requests answered from cache.
+word Si4735::getPropertyCacheHits(){
+   return _cache_hits;
 }
 
+// Return number of property requests sent to radio.
+word Si4735::getPropertyCacheMisses(){
+   return _cache_misses;
+}
+
+// Get radio's current value of property without using the bus.
+// Returns true and writes value if known.  Otherwise returns false.
+// ***** PRIVATE *****
+bool Si4735::lookup_property(word property, word *value){
+   //Check properties set or read since POWER_UP
+   byte i=find_property(property);
+   if(i<_cache_count){
+      *value=_cache[i].value;
+      return true;
+   }
+   //Check properties untouched since POWER_UP
+   for(i=0; i<NUM_PROPERTY_DEFAULTS; i++){
+      if(pgm_read_word(&property_defaults[i].property)==property){
+         if(!(_at_default & (1U<<i))) break;
+         *value=pgm_read_word(&property_defaults[i].value);
+         return true;
+      }
+   }
+   return false;
+}
+
+// Returns index of given property in _cache[].  Returns value >= _cache_count if not found.
+// ***** PRIVATE *****
+byte Si4735::find_property(word property){
+   byte i;
+   for(i=0; i<_cache_count; i++){
+      if(_cache[i].property==property) break;
+   }
+   return i;
+}
+
+// Save property's value in _cache[].  When full, entries are replaced in round robin order.
+// ***** PRIVATE *****
+void Si4735::cache_property(word property, word value){
+   byte i=find_property(property);
+   if(i>=_cache_count){
+      //New entry
+      if(_cache_count<Si47xx_PROPERTY_CACHE){
+         i=_cache_count++;
+      }else{
+         i=_cache_next;
+         if(++_cache_next>=Si47xx_PROPERTY_CACHE) _cache_next=0;
+      }
+      _cache[i].property=property;
+   }
+   _cache[i].value=value;
+}
+#endif
+
+#ifdef Si47xx_BUS_STATS
+/******************************************************************************
+*   Bus statistics                                                            *
+******************************************************************************/
+
+// Write to printBusStats() output.
+#ifdef ARDUINO
+ #define stats_text(out, text) (out)->print(text)
+ #define stats_number(out, n) (out)->print((unsigned long)(n))
+ #define stats_hex(out, n) (out)->print((unsigned long)(n), HEX)
+ #define stats_end(out) (out)->println()
+#else
+ #define stats_text(out, text) fputs((text), (out))
+ #define stats_number(out, n) fprintf((out), "%lu", (unsigned long)(n))
+ #define stats_hex(out, n) fprintf((out), "%lX", (unsigned long)(n))
+ #define stats_end(out) fputc('\n', (out))
+#endif
+
+// Print line of statistics: name,a or name,a,b.
+static void stats_line(BusStatsOutput *out, const char *name, unsigned long a){
+   stats_text(out, name);
+   stats_text(out, ",");
+   stats_number(out, a);
+   stats_end(out);
+}
+
+static void stats_line(BusStatsOutput *out, const char *name, unsigned long a, unsigned long b){
+   stats_text(out, name);
+   stats_text(out, ",");
+   stats_number(out, a);
+   stats_text(out, ",");
+   stats_number(out, b);
+   stats_end(out);
+}
+
+// Print histogram, one line per bucket.  The last bucket has no limit.
+static void stats_histogram(BusStatsOutput *out, const char *name, const unsigned long *histogram,
+ unsigned long limit){
+   for(byte i=0; i<BUS_HISTOGRAM_BUCKETS; i++, limit<<=1){
+      stats_line(out, name, i<BUS_HISTOGRAM_BUCKETS-1 ? limit : 0, histogram[i]);
+   }
+}
+
+// Zero bus statistics.
+void Si4735::clearBusStats(){
+   memset(&busStats, 0, sizeof(busStats));
+}
+
+// Print bus statistics as comma separated lines.
+void Si4735::printBusStats(BusStatsOutput *out){
+   for(byte i=0; i<busStats.opcodes; i++){
+      stats_text(out, "command,");
+      stats_hex(out, busStats.commands[i].opcode);
+      stats_text(out, ",");
+      stats_number(out, busStats.commands[i].count);
+      stats_end(out);
+   }
+   stats_line(out, "command,other", busStats.otherCommands);
+   stats_line(out, "bytes_written", busStats.bytesWritten);
+   stats_line(out, "bytes_read", busStats.bytesRead);
+   stats_line(out, "status_reads", busStats.statusReads);
+   stats_line(out, "cts_wait_us", busStats.ctsWaits, busStats.ctsMicros);
+   stats_line(out, "stc_wait_ms", busStats.stcWaits, busStats.stcMillis);
+   stats_histogram(out, "cts_histogram_us", busStats.ctsHistogram, BUS_CTS_BUCKET_US);
+   stats_histogram(out, "stc_histogram_ms", busStats.stcHistogram, BUS_STC_BUCKET_MS);
+}
+#endif
+
+#ifdef Si47xx_COMMAND_QUEUE
+/******************************************************************************
+*   Non-blocking command queue                                                *
+******************************************************************************/
+
+// Add command packet to the end of the command queue.  Maximum length is CMD_MAX_LENGTH
+// bytes.  The command is sent later by poll().  When the radio has finished the command,
+// poll() reads response_length bytes of response and passes them to the callback.
+// Returns false if the queue is full.
+bool Si4735::queueCommand(const byte *command, byte length, byte response_length,
+ CommandCallback callback){
+   //Check if queue full
+   if(_queue_count >= Si47xx_COMMAND_QUEUE) return false;
+   //Check if lengths too long
+   if(length > CMD_MAX_LENGTH) length=CMD_MAX_LENGTH;
+   if(response_length > RESP_MAX_LENGTH) response_length=RESP_MAX_LENGTH;
+
+   //Copy command into next free slot at end of ring
+   byte tail=_queue_head+_queue_count;
+   if(tail >= Si47xx_COMMAND_QUEUE) tail -= Si47xx_COMMAND_QUEUE;
+   memcpy(_queue[tail].command, command, length);
+   _queue[tail].length=length;
+   _queue[tail].response_length=response_length;
+   _queue[tail].callback=callback;
+   ++_queue_count;
+   return true;
+}
+
+// Add SET_PROPERTY command to the command queue.  Returns false if the queue is full.
+bool Si4735::queueProperty(word property, word value, CommandCallback callback){
+   byte command[6];
+   command[0] = CMD_SET_PROPERTY;
+   command[1] = 0;
+   //Property to set
+   command[2] = property >> 8;
+   command[3] = property;
+   //Property's new value
+   command[4] = value >> 8;
+   command[5] = value;
+   return queueCommand(command, sizeof(command), 0, callback);
+}
+
+// Advance the command queue by at most one bus transaction.
+// If no command is active, the next queued command is sent to the radio.  Otherwise, the
+// radio is asked if the active command has finished.  If so, its response is read and
+// passed to the command's callback.
+// Returns true if commands remain in the queue (including the active command).
+bool Si4735::poll(){
+   //Check for empty queue
+   if(!_queue_count) return false;
+
+   QueuedCommand *entry=&_queue[_queue_head];
+   if(!_queue_active){
+      //Send next command.  Do not wait for CTS.
+      send_packet(entry->command, entry->length);
+      _queue_active=true;
+      _queue_start=millis();
+      return true;
+   }
+
+   //Active command: Read status and response in one transaction.
+   /* The first byte of every response is the status byte, so there is no need to
+    * call getStatus() before reading the response.
+    */
+   byte response[RESP_MAX_LENGTH];
+   byte length = entry->response_length ? entry->response_length : 1;
+   getResponse(response, length);
+   byte result;
+   if(response[0] & CTS_MASK){
+      result = (response[0] & ERR_MASK) ? RADIO_ERROR : RADIO_OK;
+   }else{
+      //Command still running - Check timeout
+      word timeout = entry->command[0]!=CMD_POWER_UP ? RADIO_CTS_TIMEOUT : RADIO_POWER_UP_CTS_TIMEOUT;
+      if(millis()-_queue_start < timeout) return true;
+      result=RADIO_TIMEOUT;
+   }
+
+   track_command(entry->command, result);
+   //Command finished - Remove from queue before calling callback.  This permits the
+   //callback to queue more commands or send blocking commands.
+   CommandCallback callback=entry->callback;
+   _queue_active=false;
+   if(++_queue_head >= Si47xx_COMMAND_QUEUE) _queue_head=0;
+   --_queue_count;
+   if(callback){
+      callback(result, response, entry->response_length);
+   }
+   return _queue_count;
+}
+
+// Wait until all queued commands have finished.
+void Si4735::flushCommands(){
+   while(poll());
+}
+
+// Returns number of commands in the queue, including the active command.
+byte Si4735::queuedCommands(){
+   return _queue_count;
+}
+#endif
+
 // Converts hexadecimal ASCII string into command packet and sends it to the radio.
 // For debugging or advanced users.
 // ASCII chars in input string must be hexadecimal or random data will be sent to radio.
-void Si4735::sendCommand(const char *myCommand){
+byte Si4735::sendCommand(const char *myCommand){
    unsigned char digit;  //next input digit
    byte tempValue;  //build next output char
    byte index=0;  //location in output buffer
@@ -1182,6 +1710,6 @@ void Si4735::sendCommand(const char *myCommand){
       _buffer[index++] += tempValue;
    }
    //Send converted command packet to the radio using low-level version of sendCommand()
-   sendCommand(_buffer, index);
+   return sendCommand(_buffer, index);
 }
 
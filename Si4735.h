@@ -35,13 +35,18 @@ extern SoftwareSerial debugSerial;
 #define debug(method, ...)
 #endif
 
-#if ARDUINO >= 100
+#ifdef ARDUINO
+ #if ARDUINO >= 100
   #include <Arduino.h>
-#else
+ #else
   #include <WProgram.h>
-#endif
+ #endif
 
-#include <pins_arduino.h>  //Defines SPI pins: SCK, MOSI, MISO, SS
+ #include <pins_arduino.h>  //Defines SPI pins: SCK, MOSI, MISO, SS
+#else
+ // Host computer (Linux, etc.) without the Arduino software.  See Si47xxHost.h.
+ #include "Si47xxHost.h"
+#endif
 
 #ifdef __AVR__
    #include <avr/pgmspace.h>
@@ -67,6 +72,26 @@ extern SoftwareSerial debugSerial;
 // Warning: The I2C code requires Arduino software 1.0 or greater.
 //#define Si47xx_SPI
 
+// If Si47xx_SPI_SHORT_READS macro is defined, SPI response reads stop after the bytes
+// the library needs, instead of always clocking all 16 response bytes.  A status check
+// by the command queue, for example, moves 2 bytes instead of 17.  The "Si47xx
+// Programming Guide" only shows reads of all 16 bytes, so test this with your radio.
+// Command packets are always 8 bytes, as the radio requires.  Ignored for I2C, which
+// always reads only the bytes needed.
+//#define Si47xx_SPI_SHORT_READS
+
+// If Si47xx_STATIC_BUS macro is defined, the library always uses the default SPI or I2C bus
+// (radioBus) and calls it directly instead of through a pointer.  The Si4735 constructor's
+// bus argument is ignored.  Saves flash ROM and 2 bytes of SRAM.  Ignored on host computers.
+//#define Si47xx_STATIC_BUS
+
+// If Si47xx_FM_ONLY macro is defined, only FM is supported.  Code for the AM, SW, and LW
+// bands is left out and setMode() ignores those modes.  If Si47xx_AM_ONLY macro is
+// defined, only AM, SW, and LW are supported.  All RDS code and data are left out and
+// setMode() ignores FM.  Saves flash ROM, and SRAM too for Si47xx_AM_ONLY.
+//#define Si47xx_FM_ONLY
+//#define Si47xx_AM_ONLY
+
 // Radio I/O pins.  These pin assignments are based on the SparkFun shield.
 // Change these if you want when using SparkFun's breakout board.
 enum {
@@ -147,6 +172,147 @@ enum {
    RADIO_I2C_ADDRESS     =RADIO_I2C_ADDRESS_HIGH
 };
 
+// After sending a command, sendCommand() polls the radio's status byte until the radio
+// sets CTS (Clear To Send).  If CTS is not received within the timeout given below,
+// sendCommand() gives up and returns RADIO_TIMEOUT.  Timeouts are measured in ms.
+// Note: The "Si47xx Programming Guide" gives 300 µs for CTS for most commands and
+// 110 ms for POWER_UP.  The timeouts below are much longer to allow for slow buses.
+// Change these if you want.
+enum {
+   RADIO_CTS_TIMEOUT         =10,  //All commands except POWER_UP
+   RADIO_POWER_UP_CTS_TIMEOUT=500  //POWER_UP command
+};
+
+// Default timeouts in ms for waitSTC() to receive the STC (Seek/Tune Complete) interrupt.
+// Tuning takes about 60 ms (FM) or 80 ms (AM).  A seek takes about the same time for
+// each channel it checks, so a seek across the whole band can take many seconds.
+// Change these if you want.
+enum {
+   RADIO_TUNE_TIMEOUT=500,   //Used by tuneFrequencyAndWait(), frequencyUpAndWait(), etc.
+   RADIO_SEEK_TIMEOUT=20000  //Default for waitSTC()
+};
+
+// Time in ms checkAF() waits for an AF to send its PI code.  A station sends PI in every
+// RDS group, about 11 groups a second.  Change if you want.
+enum {RADIO_AF_PI_TIMEOUT=250};
+
+// Time in ms checkAF() waits after a search that found no better AF before it searches
+// again.  Audio is muted during each search.  Change if you want.
+enum {RADIO_AF_RETRY=10000};
+
+// If Si47xx_CTS_DELAY macro is defined, sendCommand() does not poll for CTS.  Instead,
+// it waits a fixed 300 µs after each command (110 ms after POWER_UP), as done by
+// release 4 and earlier of this library.  This removes all bus traffic between
+// commands, but makes every command take the worst case time.
+//#define Si47xx_CTS_DELAY
+
+// If Si47xx_COMMAND_QUEUE macro is defined, the non-blocking command queue is enabled.
+// See queueCommand() and poll() below.  The value gives the maximum number of queued
+// commands.  Each queued command uses about 12 bytes of SRAM.
+//#define Si47xx_COMMAND_QUEUE 4
+
+// If Si47xx_INTERRUPT_HANDLERS macro is defined, handlers for the radio's interrupts may
+// be registered with setInterruptHandler() and are called by dispatchInterrupts().  The
+// value gives the maximum number of handlers.  Each handler uses 3 bytes of SRAM (AVR).
+//#define Si47xx_INTERRUPT_HANDLERS 4
+
+// getRDS() passes each RDS group to a decoder picked from a table of 32 group handlers,
+// one for each group type and version.  The table is normally fixed in flash ROM.  If
+// Si47xx_RDS_HANDLERS macro is defined, the table is copied to SRAM and handlers may be
+// changed with setRDSGroupHandler().  The table uses 64 bytes of SRAM (AVR).
+//#define Si47xx_RDS_HANDLERS
+
+// If Si47xx_RDS_BUFFER macro is defined, readRDS() copies RDS groups from the radio into a
+// ring buffer in SRAM and decodeRDS() decodes them later, away from the bus.  The value
+// gives the buffer size in groups.  Each group uses 9 bytes of SRAM.
+//#define Si47xx_RDS_BUFFER 25
+
+// If Si47xx_RDS_CAPTURE macro is defined, each raw RDS group read from the radio is passed
+// to the capture sink set by setRDSCapture(), and captured groups can be decoded again by
+// replayRDS().  See Si47xxCapture.h for capture files on host computers.
+//#define Si47xx_RDS_CAPTURE
+
+// If Si47xx_RDS_STABLE macro is defined, the library also keeps rdsStable, a copy of the
+// rds structure that only holds values trusted by the RDS confidence model (see
+// RDS_THRESHOLD below), and getRDSChanges() reports which of its fields changed.  Uses
+// about 130 bytes of SRAM.
+//#define Si47xx_RDS_STABLE
+
+// If Si47xx_RDS_RTPLUS macro is defined, RadioText Plus (RT+) is decoded into the rtPlus
+// structure.  The value gives the maximum length of each text field.  Uses 3 times that
+// many bytes of SRAM, plus 12.
+//#define Si47xx_RDS_RTPLUS 32
+
+// If Si47xx_RDS_UTF8 macro is defined, RDS text keeps the characters of the RDS character
+// set (EN 50067 Annex E) instead of replacing non-ASCII characters with spaces, and
+// getRadioTextUTF8() translates the Radio Text to UTF-8.  Uses 23 bytes of SRAM.
+//#define Si47xx_RDS_UTF8
+
+// If Si47xx_RDS_ERT macro is defined, Enhanced RadioText (eRT) is decoded into the ert
+// structure.  Uses 133 bytes of SRAM.
+//#define Si47xx_RDS_ERT
+
+// If Si47xx_RDS_TMC macro is defined, Traffic Message Channel (TMC) messages sent in group
+// 8A are decoded into a queue of traffic events read by getTMCEvent().  The value gives the
+// queue size.  Each event uses 8 bytes of SRAM, plus 61 for the decoder.
+//#define Si47xx_RDS_TMC 8
+
+// If Si47xx_RDS_AF macro is defined, the Alternative Frequencies (AF) sent in group 0A are
+// decoded into afList, and checkAF() can follow the station to a stronger transmitter.
+// The value gives the maximum number of AFs kept.  Each uses 1 byte of SRAM, plus 8.
+//#define Si47xx_RDS_AF 25
+
+// If Si47xx_RDS_EON macro is defined, Enhanced Other Networks (EON) info sent in groups
+// 14A and 14B is decoded into the eon table.  The value gives the table size and must be a
+// power of 2.  Each entry uses 19 bytes of SRAM.
+//#define Si47xx_RDS_EON 8
+
+// If Si47xx_RDS_CACHE macro is defined, the PI, PTY, PS, and ECC of recently tuned FM
+// stations are remembered.  Tuning back to one shows them at once, until the first group
+// with a good PI confirms or replaces them.  The value gives the number of stations kept,
+// least recently tuned replaced first.  Each uses 14 bytes of SRAM, plus 3.
+//#define Si47xx_RDS_CACHE 4
+
+// Si47xx_PROPERTY_CACHE gives the number of radio properties remembered by the library.
+// setProperty() skips the bus when a property already has the requested value and
+// getProperty() answers from the cache when it can.  Each entry uses 4 bytes of SRAM.
+// Set to 0 to disable the cache.  May also be given on the compiler's command line.
+#ifndef Si47xx_PROPERTY_CACHE
+#define Si47xx_PROPERTY_CACHE 12
+#endif
+
+// If Si47xx_BUS_STATS macro is defined, the library counts the commands it sends to the
+// radio by opcode, the bytes it moves across the bus, and the time it spends waiting for
+// CTS and STC.  Waits are also sorted into histograms.  See busStats and printBusStats().
+// The value gives the number of different opcodes counted.  Each uses 5 bytes of SRAM,
+// plus about 110.  Without this macro, the counting code is not compiled at all.
+//#define Si47xx_BUS_STATS 16
+
+#if defined(Si47xx_FM_ONLY) && defined(Si47xx_AM_ONLY)
+ #error Define only one of Si47xx_FM_ONLY and Si47xx_AM_ONLY
+#endif
+#ifdef Si47xx_AM_ONLY
+ //No RDS in AM bands
+ #undef Si47xx_RDS_HANDLERS
+ #undef Si47xx_RDS_BUFFER
+ #undef Si47xx_RDS_CAPTURE
+ #undef Si47xx_RDS_STABLE
+ #undef Si47xx_RDS_RTPLUS
+ #undef Si47xx_RDS_UTF8
+ #undef Si47xx_RDS_ERT
+ #undef Si47xx_RDS_TMC
+ #undef Si47xx_RDS_AF
+ #undef Si47xx_RDS_EON
+ #undef Si47xx_RDS_CACHE
+#endif
+#ifndef ARDUINO
+ //Host computers have no default bus
+ #undef Si47xx_STATIC_BUS
+ #ifdef Si47xx_BUS_STATS
+  #include <stdio.h>  //printBusStats()
+ #endif
+#endif
+
 /***********************************
 * Define Si4735 library class info *
 ***********************************/
@@ -219,6 +385,51 @@ enum {
    BEGIN_DO_NOT_INIT_BUS=0b1,  //Do not initialize SPI or I2C bus
 };
 
+// Strategies for scanBand()
+enum {
+   SCAN_SEEK=0,    //Radio seeks from station to station.  Fastest when stations are few.
+   SCAN_STEP,      //Tune to every channel in the band and check it.
+   SCAN_STEP_FAST  //Same as SCAN_STEP, but uses the radio's fast, less accurate tune.
+};
+
+// Result codes returned by sendCommand() and other methods that wait for the radio.
+enum {
+   RADIO_OK=0,     //Radio completed the command
+   RADIO_TIMEOUT,  //Radio did not respond before the timeout expired
+   RADIO_ERROR,    //Radio reported an error (ERR bit set) or bus failure
+};
+
+// Called by poll() when a queued command finishes.  See queueCommand().
+// Parameters:
+//  result - RADIO_OK, RADIO_ERROR, or RADIO_TIMEOUT.
+//  response - Response from radio.  First byte is the status byte.
+//  length - Number of response bytes requested by queueCommand().
+typedef void (*CommandCallback)(byte result, const byte *response, byte length);
+
+// Called over and over by waitSTC() while it waits.  Use it to update the display, read
+// buttons, etc.  See waitSTC().
+typedef void (*IdleCallback)(void);
+
+// Called by dispatchInterrupts() when an interrupt it was registered for is set.
+// See setInterruptHandler().
+// Parameters:
+//  interrupts - Interrupts being dispatched: STC_MASK, RSQ_MASK, RDS_MASK, and ERR_MASK.
+typedef void (*InterruptHandler)(byte interrupts);
+
+class Si4735;
+
+// Called by getRDS() to decode one RDS group.  See setRDSGroupHandler().
+// Parameters:
+//  radio - Radio that received the group.  Save decoded info in radio->rds.
+//  group - Response of FM_RDS_STATUS command.  Use RDS_BLOCK_x indexes to find the group.
+// Returns true if new RDS info was collected.
+typedef bool (*RDSGroupHandler)(Si4735 *radio, const byte *group);
+
+// Called by getRDS() with each raw RDS group read from the radio.  See setRDSCapture().
+// Parameters:
+//  record - RDS_RECORD_LENGTH bytes.  Use RDS_RECORD_x indexes to find the fields.
+typedef void (*RDSCaptureSink)(const byte *record);
+
 // Maximum volume setting
 enum {MAX_VOLUME=63};
 
@@ -253,11 +464,122 @@ enum {
    LOCALE_KR,     //South Korea
 };
 
-// Threshold for RDS data
-// TODO
+// RDS confidence.  Each RDS field received is a vote for its value, weighted by the
+// block errors the radio reports: 4 for no errors, 2 for 1-2 bit errors, 1 for 3-5 bit
+// errors, and 0 if uncorrectable.  Votes for the value in the rds structure add to its
+// confidence and other votes subtract from it.  The value is replaced only when its
+// confidence runs out, and is trusted once its confidence reaches the threshold.
+enum {
+   RDS_THRESHOLD=6,       //Confidence to trust larger variables and text segments
+   RDS_BOOL_THRESHOLD=8,  //Confidence to trust boolean variables
+   RDS_CONFIDENCE_MAX=8   //Highest confidence
+};
+
+// Bits returned by getRDSChanges().  Each tells that a field of rdsStable has changed.
+enum {
+   RDS_CHANGED_PI      =1U<<0,   //programId
+   RDS_CHANGED_PTY     =1U<<1,   //programType
+   RDS_CHANGED_TP      =1U<<2,   //trafficProgram
+   RDS_CHANGED_TA      =1U<<3,   //trafficAlert
+   RDS_CHANGED_MUSIC   =1U<<4,   //music
+   RDS_CHANGED_DI      =1U<<5,   //dynamicPTY, compressedAudio, binauralAudio, or RDSStereo
+   RDS_CHANGED_ECC     =1U<<6,   //extendedCountryCode
+   RDS_CHANGED_LANGUAGE=1U<<7,   //language
+   RDS_CHANGED_PS      =1U<<8,   //programService
+   RDS_CHANGED_PTYN    =1U<<9,   //programTypeName
+   RDS_CHANGED_RT      =1U<<10,  //radioText or radioTextLen
+   RDS_CHANGED_TIME    =1U<<11,  //MJD, hour, minute, or offset
+   RDS_CHANGED_ALL     =0x0FFF
+};
+
+// Open Data Applications (ODA) announced in group 3A.  See rtPlus and ert below.
+enum {
+   RTPLUS_AID=0x4BD7,      //RadioText Plus (RT+) Application Identification
+   ERT_AID=0x6552,         //Enhanced RadioText (eRT) Application Identification
+   ODA_NO_GROUP=0xFF,      //Group of an application the station has not announced
+   RTPLUS_NO_GROUP=ODA_NO_GROUP
+};
+
+// Number of recent TMC events remembered so events repeated by the station are only queued
+// once.  Must be a power of 2.  Each uses 2 bytes of SRAM.  Change if you want.
+enum {RDS_TMC_SEEN=16};
+
+// Alternative Frequency (AF) codes sent in group 0A
+enum {
+   AF_CODE_MIN=1,          //87.6 MHz
+   AF_CODE_MAX=204,        //107.9 MHz
+   AF_CODE_FILLER=205,
+   AF_CODE_NO_AF=224,      //224+n: list of n AFs follows (n=1-25)
+   AF_CODE_LFMF=250        //Next code is an LF/MF frequency
+};
+
+// Number of AFs kept for each other network in the EON table.  Change if you want.
+enum {RDS_EON_AF=4};
+
+// Convert AF code (AF_CODE_MIN to AF_CODE_MAX) to FM frequency in 10 kHz.
+#define AF_FREQUENCY(code) (8750U+10U*(code))
+
+// Size of a buffer that holds any Radio Text in UTF-8.  See getRadioTextUTF8().
+enum {RDS_RT_UTF8_SIZE=64*3+1};
+
+// RT+ content types.  Only the most common are listed.  See IEC 62106 for all 64.
+enum {
+   RTPLUS_DUMMY=0,
+   RTPLUS_ITEM_TITLE=1,
+   RTPLUS_ITEM_ALBUM=2,
+   RTPLUS_ITEM_TRACKNUMBER=3,
+   RTPLUS_ITEM_ARTIST=4,
+   RTPLUS_ITEM_COMPOSITION=5,
+   RTPLUS_ITEM_BAND=9,
+   RTPLUS_ITEM_GENRE=11,
+   RTPLUS_PROGRAMME_NOW=33,
+   RTPLUS_PROGRAMME_HOST=40
+};
+
+// Bits returned by getRTPlusChanges()
+enum {
+   RTPLUS_CHANGED_TITLE  =0b0001,  //rtPlus.title
+   RTPLUS_CHANGED_ARTIST =0b0010,  //rtPlus.artist
+   RTPLUS_CHANGED_ALBUM  =0b0100,  //rtPlus.album
+   RTPLUS_CHANGED_RUNNING=0b1000   //rtPlus.running
+};
+
+// Indexes of RDS group in response of FM_RDS_STATUS command.  See RDSGroupHandler.
 enum {
-   RDS_THRESHOLD=3,      //Threshold for larger variables
-   RDS_BOOL_THRESHOLD=7  //Threshold for boolean variables
+   RDS_BLOCK_A_H=4,     //Block A - PI code
+   RDS_BLOCK_A_L,
+   RDS_BLOCK_B_H,       //Block B - Group type, version, TP, PTY, and group specific bits
+   RDS_BLOCK_B_L,
+   RDS_BLOCK_C_H,       //Block C
+   RDS_BLOCK_C_L,
+   RDS_BLOCK_D_H,       //Block D
+   RDS_BLOCK_D_L,
+   RDS_BLOCK_ERRORS,    //Error levels of all blocks.  See FIELD_RDS_STATUS_RESP12_BLOCK_x.
+   RDS_STATUS_LENGTH    //Length of response
+};
+
+// Number of RDS group types and versions: 16 types (0-15), each with version A and B.
+enum {RDS_GROUP_TYPES=32};
+
+// RDS group sizes
+enum {
+   RDS_GROUP_LENGTH=RDS_STATUS_LENGTH-RDS_BLOCK_A_H,  //Bytes of one raw group: blocks A-D and errors
+   RDS_FIFO_SIZE=25                                   //Radio's RDS FIFO size in groups
+};
+
+// Indexes of RDS capture record.  See setRDSCapture().  Bytes 4-12 match FM_RDS_STATUS.
+enum {
+   RDS_RECORD_TIME=0,                   //millis() when group was read, 4 bytes, low byte first
+   RDS_RECORD_BLOCKS=RDS_BLOCK_A_H,     //Blocks A-D, 8 bytes, high byte first
+   RDS_RECORD_ERRORS=RDS_BLOCK_ERRORS,  //Block error levels.  See FIELD_RDS_STATUS_RESP12_BLOCK_x.
+   RDS_RECORD_FLAGS,                    //RDS_RECORD_SYNC and RDS_RECORD_OVERFLOW bits
+   RDS_RECORD_LENGTH                    //Length of record
+};
+
+// Bits of RDS capture record's flags
+enum {
+   RDS_RECORD_SYNC    =0b01,  //RDS was synchronized
+   RDS_RECORD_OVERFLOW=0b10   //Radio's RDS FIFO overflowed before group was read
 };
 
 // RDS Extended Country Codes
@@ -322,6 +644,77 @@ typedef struct RSQMetrics {
                      //(Si4735-D50 or later)
 };
 
+// Station found by scanBand().
+typedef struct StationRecord {
+   word frequency;   //kHz for AM, SW, LW or 10 kHz for FM
+   byte RSSI;        //Received Signal Strength Indication measured in dBµV
+   byte SNR;         //Signal to Noise Ratio measured in dB
+   byte multipath;   //Multipath metric (FM only, Si4735-D50 or later)
+} StationRecord;
+
+// Traffic event from an RDS TMC message (ISO 14819-1).  Filled in by getTMCEvent().
+typedef struct TMCEvent {
+   word event;       //Event code (1-2047).  See ISO 14819-2 for meanings.
+   word location;    //Location code in the station's location table
+   byte extent;      //Number of further locations the event covers (0-7)
+   bool negative;    //Event extends in the negative direction of the road
+   byte duration;    //Duration and persistence code (0-7), 0 if not given
+   bool diversion;   //Drivers are advised to take a diversion
+} TMCEvent;
+
+// Other network (station) described by the tuned station's EON groups.  See eon table.
+typedef struct EONStation {
+   word programId;             //PI code, 0 if entry is unused
+   char programService[9];     //PS name, spaces until received
+   byte programType;           //PTY code
+   ternary trafficProgram;     //TP flag
+   ternary trafficAlert;       //TA flag, unknown until received
+   byte frequencies[RDS_EON_AF];  //AF codes.  0 if unused.  See AF_FREQUENCY().
+} EONStation;
+
+#ifdef Si47xx_BUS_STATS
+// Histograms in BusStats.  Bucket 0 counts waits shorter than the bucket size.  Each
+// following bucket counts waits up to twice as long as the one before.  The last bucket
+// counts all longer waits.
+enum {
+   BUS_HISTOGRAM_BUCKETS=10,
+   BUS_CTS_BUCKET_US=32,  //CTS waits: <32 µs, <64 µs, ... <8192 µs, longer
+   BUS_STC_BUCKET_MS=4    //STC waits: <4 ms, <8 ms, ... <1024 ms, longer
+};
+
+// Bus statistics collected when Si47xx_BUS_STATS is defined.  See busStats.
+typedef struct BusStats {
+   struct {
+      byte opcode;                  //Command byte
+      unsigned long count;          //Times sent
+   } commands[Si47xx_BUS_STATS];    //In order first sent
+   byte opcodes;                    //Valid entries in commands[]
+   unsigned long otherCommands;     //Commands not counted because commands[] was full
+   unsigned long bytesWritten;      //Command bytes written to radio
+   unsigned long bytesRead;         //Status and response bytes read from radio
+   unsigned long statusReads;       //Calls to getStatus(), including CTS polls
+   unsigned long ctsWaits;          //Times sendCommand() waited for CTS
+   unsigned long ctsMicros;         //Total time of those waits in µs
+   unsigned long stcWaits;          //Times waitSTC() waited for STC
+   unsigned long stcMillis;         //Total time of those waits in ms
+   unsigned long ctsHistogram[BUS_HISTOGRAM_BUCKETS];
+   unsigned long stcHistogram[BUS_HISTOGRAM_BUCKETS];
+} BusStats;
+
+// Where printBusStats() writes.  Serial on Arduino, stdout or a file on host computers.
+#ifdef ARDUINO
+ typedef Print BusStatsOutput;
+#else
+ typedef FILE BusStatsOutput;
+#endif
+#endif
+
+// Property and its value.  Used by applyProperties().
+typedef struct PropertyValue {
+   word property;
+   word value;
+} PropertyValue;
+
 /*****************************************
 * Si47xx radio command and property info *
 *****************************************/
@@ -630,6 +1023,9 @@ enum {
    /* See ASQ interrupts above. */
 };
 
+// Bus classes used to talk to radio
+#include "Si47xxBus.h"
+
 /* The normal sequence for using the Si4735 class library is:
  *
  *    Si4735 radio;  // Create object
@@ -656,8 +1052,13 @@ enum {
  */
 class Si4735 {
    public:
-      /* The Si4735 class constructor to initialize a new object. */
-      Si4735();
+      /* The Si4735 class constructor to initialize a new object.
+       * Parameters:
+       *  bus - Bus used to talk to radio.  See Si47xxBus.h.  If not given, the library's
+       *        SPI or I2C bus is used as selected by the Si47xx_SPI macro above.
+       *        On a host computer, a bus must be given.
+       */
+      Si4735(Si47xxBus *bus=0);
 
       /* Applies power to and resets the radio chip.
        * Parameters:
@@ -706,8 +1107,10 @@ class Si4735 {
        */
       void tuneFrequency(word frequency);
 
-      /* Equivalent to tuneFrequency() followed by waitSTC(). */
-      void tuneFrequencyAndWait(word frequency);
+      /* Equivalent to tuneFrequency() followed by waitSTC(RADIO_TUNE_TIMEOUT, idle).
+       * Returns RADIO_OK, RADIO_TIMEOUT, or RADIO_ERROR like waitSTC().
+       */
+      byte tuneFrequencyAndWait(word frequency, IdleCallback idle=0);
 
       /* Increments the currently tuned frequency by the current spacing returned by getSpacing().
        * If the new frequency would exceed the top of band, the frequency wraps to the bottom.
@@ -718,8 +1121,10 @@ class Si4735 {
        */
       word frequencyUp(void);
 
-      /* Equivalent to frequencyUp() followed by waitSTC(). */
-      word frequencyUpAndWait(void);
+      /* Equivalent to frequencyUp() followed by waitSTC(RADIO_TUNE_TIMEOUT, idle).
+       * Returns the newly tuned frequency, or 0 if waitSTC() failed.
+       */
+      word frequencyUpAndWait(IdleCallback idle=0);
 
       /* Decrements the currently tuned frequency by the current spacing returned by getSpacing().
        * If the new frequency would exceed the bottom of band, the frequency wraps to the top.
@@ -728,13 +1133,23 @@ class Si4735 {
        */
       word frequencyDown(void);
 
-      /* Equivalent to frequencyDown() followed by waitSTC(). */
-      word frequencyDownAndWait(void);
-
-      /* Wait for STC (Seek/Tune Complete) interrupt from radio chip.  Returns with STC
-       * interrupt cleared.
+      /* Equivalent to frequencyDown() followed by waitSTC(RADIO_TUNE_TIMEOUT, idle).
+       * Returns the newly tuned frequency, or 0 if waitSTC() failed.
+       */
+      word frequencyDownAndWait(IdleCallback idle=0);
+
+      /* Wait for STC (Seek/Tune Complete) interrupt from radio chip.
+       * While waiting, the idle callback, if given, is called over and over.  If no interrupt
+       * signal is received before the timeout, the radio is asked for its interrupts once more
+       * in case the signal was lost.
+       * Returns RADIO_OK if STC received, RADIO_TIMEOUT if not received before the timeout,
+       * or RADIO_ERROR if the radio could not be read.
+       * Parameters:
+       *  timeout - Maximum time to wait in ms.
+       *  idle - Called while waiting.  May be 0.  It must not call methods that wait for
+       *         interrupts, such as checkRDS() or dispatchInterrupts().  It may call getRDS().
        */
-      void waitSTC(void);
+      byte waitSTC(word timeout=RADIO_SEEK_TIMEOUT, IdleCallback idle=0);
 
       /* Commands the radio to seek up to the next valid channel. If the top of
        * the band is reached, seek will continue from the bottom of the band.
@@ -751,6 +1166,22 @@ class Si4735 {
        */
       void seekDown(void);
 
+      /* Scans the whole band, from getBandBottom() to getBandTop(), and saves the stations
+       * found in the given array in order of frequency.  A station is saved if the radio
+       * reports it valid, which uses the radio's SEEK_TUNE_SNR and SEEK_TUNE_RSSI threshold
+       * properties.  RSQ is only read for valid channels.  The radio is retuned to the
+       * current frequency afterwards.
+       * Returns number of stations saved.
+       * Parameters:
+       *  stations - Array to receive stations.
+       *  max_stations - Number of entries in array.  The scan stops when it is full.
+       *  strategy - SCAN_SEEK, SCAN_STEP, or SCAN_STEP_FAST.  See constants above.
+       *  time - If given, receives time the scan took in ms.
+       *  idle - Called while waiting for the radio.  See waitSTC().
+       */
+      byte scanBand(StationRecord *stations, byte max_stations, byte strategy=SCAN_SEEK,
+       unsigned long *time=0, IdleCallback idle=0);
+
       /* Tell radio to cancel seek operation.  Returns the frequency of the currently
        * tuned station and clears the STC interrupt.
        */
@@ -778,6 +1209,7 @@ class Si4735 {
        */
       word currentFrequency();
 
+      #ifndef Si47xx_AM_ONLY
       /* Collects RDS information from radio chip.  Returns true if new info found.
        * Only works in FM mode.  Collected info is located below in the 'rds' structure
        * inside this class object.
@@ -787,6 +1219,60 @@ class Si4735 {
       /* Equivalent to getRDS() but first checks RDS interrupt for new RDS data. */
       bool checkRDS(void);
 
+      /* Sets how many RDS groups (1 to RDS_FIFO_SIZE) the radio collects in its FIFO before
+       * it sends an RDS interrupt.  The default of 1 interrupts for every group, about 11
+       * times a second.  Larger batches mean fewer interrupts, and each getRDS() drains the
+       * whole batch at once.  Leave room in the FIFO for groups that arrive before the
+       * interrupt is handled, or they are lost.  Kept across mode changes.
+       */
+      void setRDSBatch(byte groups);
+
+      #ifdef Si47xx_RDS_BUFFER
+      /* Reads all RDS groups waiting in the radio into the RDS buffer without decoding
+       * them.  Stops early if the buffer is full.  Also clears RDS interrupt.
+       * Returns number of groups read.  If not FM mode, it returns 0.
+       */
+      byte readRDS(void);
+
+      /* Decodes the RDS groups saved by readRDS() and empties the buffer.  Does not use
+       * the bus.  Returns true if new info found.
+       */
+      bool decodeRDS(void);
+      #endif
+
+      #ifdef Si47xx_RDS_CAPTURE
+      /* Sets function called with each raw RDS group read from the radio, before the group
+       * is decoded.  Use to record RDS streams.  0 turns capture off.
+       */
+      void setRDSCapture(RDSCaptureSink sink);
+
+      /* Decodes a group saved by the capture sink as if getRDS() had just read it from
+       * the radio.  Does not use the bus or check the mode, so a host computer can replay
+       * recorded streams.  Returns true if new info found.
+       */
+      bool replayRDS(const byte *record);
+      #endif
+
+      #ifdef Si47xx_RDS_HANDLERS
+      /* Sets the decoder getRDS() calls for the given RDS group.  Common info in every group
+       * (PI, PTY, TP, groupA, and groupB) is saved before the handler is called.  A handler
+       * of 0 ignores the group.  Returns the previous handler, so a new handler may call
+       * it to keep the library's decoding.
+       * Parameters:
+       *  type - Group type 0-15.
+       *  version - 0 for version A, 1 for version B.
+       */
+      RDSGroupHandler setRDSGroupHandler(byte type, byte version, RDSGroupHandler handler);
+      #endif
+
+      /* Returns true if rds.programId has been received with confidence.  See RDS_THRESHOLD. */
+      bool isProgramIdTrusted(void);
+
+      /* Returns true if every segment of rds.programService has been received with
+       * confidence.
+       */
+      bool isProgramServiceTrusted(void);
+
       /* Saves the call sign derived from the current RBDS PI code in the given 5 character
        * buffer.  Returns true if buffer has a valid call sign.  Otherwise, returns false and
        * the buffer is initialized with fill characters.
@@ -798,12 +1284,19 @@ class Si4735 {
        * Message string is saved in given 17 character buffer.
        */
       void getProgramTypeStr(char text[17]);
+      #endif
 
       /* Clears RDS station info so that data from previous stations are not overlayed on
        * the current station.  Automatically called when the frequency is changed.
        */
       void clearStationInfo(void);
 
+      #ifdef Si47xx_RDS_CACHE
+      /* Forgets RDS info saved for recently tuned stations. */
+      void clearRDSCache(void);
+      #endif
+
+      #ifndef Si47xx_AM_ONLY
       /* Retrieves the last date and time broadcasted from the tuned station and
        * writes the local date and time to the given structure.
        * Returns true if station has broadcast date and time at least once,
@@ -817,6 +1310,7 @@ class Si4735 {
        * otherwise, it returns false and writes nothing to the structure.
        */
       bool getLocalTime(Time *time);
+      #endif
 
       /* Retrieves the Received Signal Quality parameters/metrics. */
       void getRSQ(RSQMetrics *RSQ);
@@ -858,17 +1352,19 @@ class Si4735 {
       /* Returns mute status. */
       bool getMute(void);
 
-      /* Sends a command packet to the Si4735.  See the "Si47xx Programming Guide" for a description
-       * of the commands and their responses.
+      /* Sends a command packet to the Si4735 and waits for CTS.  See the "Si47xx Programming Guide"
+       * for a description of the commands and their responses.
+       * Returns RADIO_OK when the radio is ready for the next command, RADIO_ERROR if the radio
+       * rejected the command, or RADIO_TIMEOUT if CTS was not received in time.
        * Parameters:
        *  command - Command to be sent to the radio.
        *  length - Number of bytes in command packet.  Maximum length is CMD_MAX_LENGTH.
        */
-      void sendCommand(const byte *command, byte length);
+      byte sendCommand(const byte *command, byte length);
 
       #ifdef __AVR__
       /* Same as sendCommand() but command is located in flash ROM (PROGMEM). */
-      void sendCommand_P(const byte PROGMEM *command_P, byte length);
+      byte sendCommand_P(const byte PROGMEM *command_P, byte length);
       #else
       /* Dummy version for ARM based Arduinos. */
       #define sendCommand_P(command, length) sendCommand((command), (length))
@@ -879,8 +1375,40 @@ class Si4735 {
        *  myCommand - A null terminated ASCII string consisting of hexadecimal characters.
        *  The string is converted into raw bytes and sent to the radio module.  For debugging
        *  or advanced users.  The command format can be found in the "Si47xx Programming Guide."
+       * Returns the same result codes as sendCommand().
+       */
+      byte sendCommand(const char *myCommand);
+
+      #ifdef Si47xx_COMMAND_QUEUE
+      /* Adds a command packet to the non-blocking command queue.  Returns immediately.
+       * Queued commands are sent one at a time by poll().  When the radio finishes a command,
+       * response_length bytes of response are read and passed to the callback, if given.
+       * Returns false if the queue is full.
+       * Warning: Blocking methods (setProperty(), tuneFrequency(), etc.) first call
+       * flushCommands() to finish all queued commands.
+       * Parameters:
+       *  command - Command to be sent to the radio.  It is copied into the queue.
+       *  length - Number of bytes in command packet.  Maximum length is CMD_MAX_LENGTH.
+       *  response_length - Number of response bytes to read.  Maximum length is RESP_MAX_LENGTH.
+       *  callback - Called with the response when the command finishes.  May be 0.
+       */
+      bool queueCommand(const byte *command, byte length, byte response_length=0,
+       CommandCallback callback=0);
+
+      /* Adds a SET_PROPERTY command to the command queue.  Otherwise identical to queueCommand(). */
+      bool queueProperty(word property, word value, CommandCallback callback=0);
+
+      /* Advances the command queue by at most one bus transaction and returns immediately.
+       * Call from loop() as often as possible.  Returns true if commands remain queued.
        */
-      void sendCommand(const char *myCommand);
+      bool poll(void);
+
+      /* Waits until all queued commands have finished. */
+      void flushCommands(void);
+
+      /* Returns number of commands in the queue, including the command being executed. */
+      byte queuedCommands(void);
+      #endif
 
       /* Gets the long response (16 bytes) from the radio.  The response is written
        * to the given buffer.  Only those bytes that will fit are written.
@@ -929,12 +1457,88 @@ class Si4735 {
        */
       void clearInterrupts(byte interrupt_mask);
 
+      #ifdef Si47xx_INTERRUPT_HANDLERS
+      /* Registers a handler to be called by dispatchInterrupts() when any interrupt in mask
+       * is set.  The mask is any combination of STC_MASK, RSQ_MASK, RDS_MASK, and ERR_MASK.
+       * If the handler is already registered, its mask is replaced.  A mask of 0 removes
+       * the handler.  Returns false if there is no room for another handler.
+       */
+      bool setInterruptHandler(byte mask, InterruptHandler handler);
+
+      /* Call from loop() as often as possible.  Each time an interrupt signal is received,
+       * the radio's interrupts are read once and every handler whose mask matches is called
+       * in turn.  ERR is dispatched once for each batch of commands the radio rejected.
+       * Handlers should clear their interrupt, for example by calling getRDS(), getRSQ(),
+       * or getFrequency(true).  They may call any other method of this class.
+       * Returns the interrupts dispatched, or 0 if there were none.
+       * Warning: dispatchInterrupts() and currentInterrupts() both use up the interrupt
+       * signal.  Outside of handlers, do not also call checkRDS(), checkRSQ(),
+       * checkFrequency(), waitSTC(), or currentInterrupts().
+       */
+      byte dispatchInterrupts(void);
+      #endif
+
       /* Set given property. */
       void setProperty(word property, word value);
 
       /* Get given property. */
       word getProperty(word property);
 
+      /* Set list of properties.  Equivalent to calling setProperty() for each item.
+       * Properties which the radio already has at the requested value, either because they
+       * were set earlier or because the value is the radio's reset default, are skipped.
+       * Parameters:
+       *  list - Array of property and value pairs.
+       *  count - Number of items in list.
+       */
+      void applyProperties(const PropertyValue *list, byte count);
+
+      #ifdef __AVR__
+      /* Same as applyProperties() but list is located in flash ROM (PROGMEM). */
+      void applyProperties_P(const PropertyValue PROGMEM *list_P, byte count);
+      #else
+      /* Dummy version for ARM based Arduinos. */
+      #define applyProperties_P(list, count) applyProperties((list), (count))
+      #endif
+
+      #if Si47xx_PROPERTY_CACHE
+      /* Forget all cached property values.  Called automatically by begin() and whenever
+       * a POWER_UP or POWER_DOWN command is sent.  Call this if you change properties
+       * behind the library's back, for example with a PATCH or custom firmware.
+       */
+      void clearPropertyCache(void);
+
+      /* Number of setProperty() and getProperty() calls answered by the property cache
+       * without using the bus.
+       */
+      word getPropertyCacheHits(void);
+
+      /* Number of setProperty() and getProperty() calls that had to use the bus. */
+      word getPropertyCacheMisses(void);
+      #endif
+
+      #ifdef Si47xx_BUS_STATS
+      /* Bus statistics.  Counting starts when the object is created. */
+      BusStats busStats;
+
+      /* Zeroes busStats. */
+      void clearBusStats(void);
+
+      /* Prints busStats as comma separated lines:
+       *    command,opcode,count      One line per opcode, opcode in hexadecimal
+       *    command,other,count       Commands not counted by opcode
+       *    bytes_written,count
+       *    bytes_read,count
+       *    status_reads,count
+       *    cts_wait_us,waits,total
+       *    stc_wait_ms,waits,total
+       *    cts_histogram_us,limit,count   One line per bucket.  Waits shorter than limit.
+       *    stc_histogram_ms,limit,count   The last bucket gives limit 0 for "longer".
+       * Example:  radio.printBusStats(&Serial);
+       */
+      void printBusStats(BusStatsOutput *out);
+      #endif
+
       /* Set top/bottom of receive band.  Overides setMode()'s default.
        * Frequency is measured in kHz for AM, SW, LW and in 10 kHz increments for FM.
        */
@@ -975,8 +1579,9 @@ class Si4735 {
          byte chip;            //Chip revision in ASCII
       } revision;
 
+      #ifndef Si47xx_AM_ONLY
       /* RDS and RBDS data */
-      struct{
+      struct RDSData {
          word programId;            //Program Identification (PI) code - unique code assigned to program.
                                     //In the US, except for simulcast stations, each station has a unique PI.
                                     //PI = 0 if no RDS info received.
@@ -1015,6 +1620,143 @@ class Si4735 {
                                     //If offset==NO_DATE_TIME then MJD, hour, minute are invalid.
       } rds;
 
+      #ifdef Si47xx_RDS_STABLE
+      /* Same as rds, but a field only changes when the new value is trusted.  Fields which
+       * are not voted on, such as groupA and RDSSignal, are not kept up to date.
+       */
+      RDSData rdsStable;
+
+      /* Returns RDS_CHANGED_x bits for the fields of rdsStable that have changed since the
+       * last call, and clears them.  Use to update a display only when needed.
+       */
+      word getRDSChanges(void);
+      #endif
+
+      #ifdef Si47xx_RDS_RTPLUS
+      /* RadioText Plus (RT+).  Tags sent by the station that point into rds.radioText.
+       * The station announces RT+ in group 3A along with the group type it uses for the
+       * tags.  Title, artist, and album are copied out of the Radio Text when a tag for
+       * them arrives and the tagged part of the Radio Text has been received with
+       * confidence.  Text fields are empty until then.
+       */
+      struct {
+         byte group;             //Group carrying RT+ (type<<1 | version) or RTPLUS_NO_GROUP
+         bool running;           //Item running bit - true while the item (song) is on air
+         ternary toggle;         //Item toggle bit - changes when a new item starts
+         struct {
+            byte type;           //Content type, RTPLUS_x constant
+            byte start;          //Position of first char in rds.radioText
+            byte length;         //Number of chars
+         } tags[2];              //Tags in last RT+ group
+         char title[Si47xx_RDS_RTPLUS+1];
+         char artist[Si47xx_RDS_RTPLUS+1];
+         char album[Si47xx_RDS_RTPLUS+1];
+      } rtPlus;
+
+      /* Returns RTPLUS_CHANGED_x bits for fields of rtPlus that have changed since the last
+       * call, and clears them.
+       */
+      byte getRTPlusChanges(void);
+      #endif
+
+      #ifdef Si47xx_RDS_TMC
+      /* Removes the oldest Traffic Message Channel event from the queue and copies it to
+       * the given structure.  Returns false if the queue is empty.  Events the station
+       * repeats are queued only once.  While the queue is full, new events are dropped;
+       * they are queued when the station repeats them after room is made.
+       */
+      bool getTMCEvent(TMCEvent *event);
+
+      /* Returns number of TMC events in the queue. */
+      byte queuedTMCEvents(void);
+      #endif
+
+      #ifdef Si47xx_RDS_AF
+      /* Alternative Frequencies (AF) of the station with PI code programId.  The list is
+       * kept when tuning, so it stays valid while checkAF() follows the station from one
+       * transmitter to another, and is replaced once a station with another PI is received.
+       * Lists sent with method A and the method B list of the tuned transmitter are
+       * decoded.  Regional variants and LF/MF frequencies are skipped.
+       */
+      struct {
+         word programId;                   //PI of station that sent list, 0 if none
+         byte count;                       //Number of AFs
+         byte frequencies[Si47xx_RDS_AF];  //AF codes.  See AF_FREQUENCY().
+      } afList;
+
+      /* Turns AF following on or off.  When on, checkAF() looks for a stronger transmitter
+       * once the RSSI (dBµV) or SNR (dB) falls below the given values.  0 for both turns
+       * AF following off.
+       */
+      void setAFFollow(byte minRSSI, byte minSNR);
+
+      /* If AF following is on and the signal is below the values given to setAFFollow(),
+       * briefly tunes each AF in afList to measure its RSSI.  Then, strongest first, AFs
+       * stronger than the current signal are checked for the station's PI code and the
+       * radio stays on the first that sends it.  Audio is muted meanwhile.  Takes about
+       * 60 ms per AF plus up to RADIO_AF_PI_TIMEOUT for each PI check.  The station info
+       * in rds is kept.  After a search that finds no better AF, the next search waits
+       * RADIO_AF_RETRY ms.  Call from loop() every second or so.
+       * Returns the new frequency, or 0 if the radio stayed on (or returned to) the
+       * current frequency.
+       * Parameters:
+       *  idle - Called while waiting for the radio.  See waitSTC().
+       */
+      word checkAF(IdleCallback idle=0);
+      #endif
+
+      #ifdef Si47xx_RDS_EON
+      /* Enhanced Other Networks (EON).  Other stations the tuned station gives info about,
+       * such as stations of the same broadcaster.  Entries are placed by a hash of the PI
+       * code, so they are not in any order.  When the table is full, a new station
+       * replaces one.  Cleared when tuning.
+       */
+      EONStation eon[Si47xx_RDS_EON];
+
+      /* Returns entry in eon table for given PI code, or 0 if none. */
+      const EONStation *findEON(word programId);
+
+      /* Returns an EON station sending a traffic announcement now (TP and TA set), or 0
+       * if none.  The radio may be tuned to one of its frequencies for the announcement.
+       */
+      const EONStation *findEONTrafficAlert(void);
+      #endif
+
+      #ifdef Si47xx_RDS_UTF8
+      /* Translates the Radio Text to UTF-8 in the given buffer.  Always pass the same
+       * buffer.  Only the Radio Text segments changed since the last call are translated
+       * again; the rest of the buffer is kept.  Text that does not fit is cut at a
+       * character boundary.  A buffer of RDS_RT_UTF8_SIZE bytes always fits.
+       * Returns true if the buffer changed.
+       */
+      bool getRadioTextUTF8(char *utf8, byte size);
+
+      /* Translates length characters of RDS text, such as rds.programService, to UTF-8.
+       * Returns length of UTF-8 string saved in buffer.
+       */
+      static byte RDSToUTF8(char *utf8, byte size, const char *text, byte length);
+      #endif
+
+      #ifdef Si47xx_RDS_ERT
+      /* Enhanced RadioText (eRT).  Radio Text of up to 128 bytes in UTF-8 or UCS-2 that
+       * can hold any language.  The station announces eRT in group 3A along with the group
+       * type it uses for the text.
+       */
+      struct {
+         byte group;             //Group carrying eRT (type<<1 | version) or ODA_NO_GROUP
+         bool utf8;              //True if text is UTF-8, false if UCS-2 (high byte first)
+         bool rightToLeft;       //Text direction
+         byte length;            //Bytes before end of message marker, 0 if none received
+         char text[129];         //Text as sent.  Bytes not yet received are 0.
+      } ert;
+
+      /* Saves the eRT text as UTF-8 in the given buffer.  Text that does not fit is cut at
+       * a character boundary.  Returns length of UTF-8 string.
+       */
+      byte getEnhancedRadioTextUTF8(char *utf8, byte size);
+      #endif
+      #endif
+
    private:
       word _frequency;            //Current tuned frequency - 0 if unknown or no frequency tuned
       word _top, _bottom;         //Band limits
@@ -1025,25 +1767,224 @@ class Si4735 {
       byte _volume;               //Current volume
       bool _mute;                 //Current mute status
       byte _interrupts;           //Current radio interrupt status
-      #ifndef Si47xx_SPI  //I2C
-      byte _address;              //Radio's I2C address
+      #ifndef Si47xx_STATIC_BUS
+      Si47xxBus *_bus;            //Bus used to talk to radio
       #endif
+      #ifndef Si47xx_AM_ONLY
       /* RDS and RBDS data */
       ternary _abRadioText;       //Indicates new radioText[] string
       ternary _abProgramTypeName; //Indicates new programTypeName[] string
-      /* RDS data counters */
-      byte _extendedCountryCode_count;
-      byte _language_count;
+      /* RDS fields with confidence votes */
+      enum {
+         CONF_PI=0,
+         CONF_PTY,
+         CONF_TP,
+         CONF_TA,
+         CONF_MUSIC,
+         CONF_DI,                 //4 DI flags
+         CONF_ECC=CONF_DI+4,
+         CONF_LANGUAGE,
+         CONF_PS,                 //4 segments
+         CONF_PTYN=CONF_PS+4,     //2 segments
+         CONF_RT=CONF_PTYN+2,     //16 segments
+         CONF_COUNT=CONF_RT+16
+      };
+      byte _confidence[CONF_COUNT];  //Confidence in each field of rds
+      #ifdef Si47xx_RDS_STABLE
+      word _rds_changes;          //RDS_CHANGED_x bits not yet returned by getRDSChanges()
+      #endif
+      byte _rds_batch;            //FM_RDS_INT_FIFO_COUNT property, 0 for every group
+      #ifdef Si47xx_RDS_BUFFER
+      /* Ring buffer of raw RDS groups waiting for decodeRDS() */
+      byte _rds_buffer[Si47xx_RDS_BUFFER][RDS_GROUP_LENGTH];
+      byte _rds_head;             //Index of oldest group
+      byte _rds_count;            //Number of groups in buffer
+      #endif
+      #ifdef Si47xx_RDS_CAPTURE
+      RDSCaptureSink _rds_sink;   //Receives raw RDS groups
+      #endif
+      /* Default RDS group handlers, indexed by type<<1 | version.  Located in PROGMEM. */
+      static const RDSGroupHandler rds_default_handlers[RDS_GROUP_TYPES];
+      #ifdef Si47xx_RDS_HANDLERS
+      RDSGroupHandler _rds_handlers[RDS_GROUP_TYPES];
+      #endif
+      /* Built in RDS group handlers */
+      static bool rds_group_0(Si4735 *radio, const byte *group);    //0A, 0B, and 15B
+      static bool rds_group_1A(Si4735 *radio, const byte *group);
+      static bool rds_group_2(Si4735 *radio, const byte *group);    //2A and 2B
+      static bool rds_group_4A(Si4735 *radio, const byte *group);
+      static bool rds_group_10A(Si4735 *radio, const byte *group);
+      #if defined(Si47xx_RDS_RTPLUS) || defined(Si47xx_RDS_ERT)
+      static bool rds_group_3A(Si4735 *radio, const byte *group);
+      #endif
+      #ifdef Si47xx_RDS_ERT
+      static bool rds_group_ert(Si4735 *radio, const byte *group);     //Group given by 3A
+      #endif
+      #ifdef Si47xx_RDS_TMC
+      static bool rds_group_8A(Si4735 *radio, const byte *group);
+      /* Ring buffer of TMC events waiting for getTMCEvent() */
+      TMCEvent _tmc_queue[Si47xx_RDS_TMC];
+      byte _tmc_head;             //Index of oldest event
+      byte _tmc_count;            //Number of events in queue
+      word _tmc_seen[RDS_TMC_SEEN];  //Hashes of recent events, indexed by hash.  0 if empty.
+      /* Multi-group message being received */
+      TMCEvent _tmc_message;
+      byte _tmc_ci;               //Continuity index of message, or 0xFF if none
+      byte _tmc_next;             //Group sequence indicator expected next
+      byte _tmc_groups;           //Free format groups received
+      unsigned long _tmc_bits[4]; //28 bits of free format data from each group
+      /* Queue event unless it was seen recently.  Returns true if queued. */
+      bool tmc_add(const TMCEvent *event);
+      /* Read labels of free format data into _tmc_message */
+      void tmc_labels(void);
+      #endif
+      #ifdef Si47xx_RDS_AF
+      byte _af_header;            //AF code in head of list being received, 0 if none
+      bool _af_lfmf;              //Next AF code is an LF/MF frequency
+      byte _af_min_rssi;          //AF following thresholds.  0 for both if off.
+      byte _af_min_snr;
+      bool _af_searching;         //checkAF() is tuning AFs.  afList is not changed.
+      bool _af_hold;              //Last search failed.  Wait RADIO_AF_RETRY before next.
+      unsigned long _af_hold_start;  //millis() when last search failed
+      /* Decode AF codes from block C of group 0A.  Returns true if afList changed. */
+      bool af_decode(byte first, byte second);
+      /* Add AF code to afList if new.  Returns true if added. */
+      bool af_add(byte code);
+      /* Read RDS groups until PI code is received.  Returns true if it matches. */
+      bool af_check_pi(word programId, IdleCallback idle);
+      #endif
+      #ifdef Si47xx_RDS_EON
+      static bool rds_group_14(Si4735 *radio, const byte *group);   //14A and 14B
+      /* Returns index of PI code in eon[], adding it if needed */
+      byte eon_entry(word programId);
+      /* Returns index where search for PI code in eon[] starts */
+      static byte eon_hash(word programId);
+      #endif
+      #ifdef Si47xx_RDS_CACHE
+      /* RDS info of recently tuned stations, most recent first */
+      struct {
+         word frequency;
+         word programId;
+         byte programType;
+         byte extendedCountryCode;
+         char programService[8];
+      } _rds_cache[Si47xx_RDS_CACHE];
+      byte _rds_cache_count;      //Number of valid entries in _rds_cache[]
+      word _rds_cached_pi;        //PI restored from cache and not yet confirmed, or 0
+      /* Save RDS info of tuned station in cache if PI is trusted */
+      void rds_cache_save(void);
+      /* Show cached RDS info of tuned frequency, if any */
+      void rds_cache_restore(void);
+      /* First good PI after restore.  Drops restored info if PI is not the cached one. */
+      void rds_cache_check(word programId);
+      #endif
+      #ifdef Si47xx_RDS_UTF8
+      /* State of getRadioTextUTF8() */
+      char *_utf8_text;           //Buffer last given
+      byte _utf8_size;            //Its size
+      byte _utf8_length;          //rds.radioTextLen when translated
+      byte _utf8_segment;         //Radio Text segment size when translated
+      word _utf8_dirty;           //Radio Text segments not yet translated
+      byte _utf8_end[16];         //End of each segment in _utf8_text
+      #endif
+      #ifdef Si47xx_RDS_RTPLUS
+      static bool rds_group_rtplus(Si4735 *radio, const byte *group);  //Group given by 3A
+      byte _rtplus_changes;       //RTPLUS_CHANGED_x bits not yet returned
+      /* Copy tagged part of Radio Text to field.  Returns true if field changed. */
+      bool rtplus_extract(char *field, byte start, byte length);
+      #endif
+      /* Send FM_RDS_STATUS and read response.  Returns groups radio had, including the
+       * one returned.  0 if none.
+       */
+      byte read_rds_group(byte *response);
+      /* Decode one RDS group given in FM_RDS_STATUS response format */
+      bool decode_group(const byte *response);
+      /* Vote weight of data from given blocks of an RDS group.  blocks is any combination
+       * of FIELD_RDS_STATUS_RESP12_BLOCK_x.
+       */
+      static byte rds_weight(const byte *group, byte blocks);
+      /* Vote for value of an RDS field.  candidate points to the field in rds.
+       * Returns true if rds changed.
+       */
+      bool rds_vote(byte field, void *candidate, const void *value, byte size, byte weight);
+      #endif
+      /* True if mode is FM rather than AM, SW, or LW.  Mode must not be RADIO_OFF.  Constant
+       * when only one set of bands is compiled in, so the compiler drops the other's code.
+       */
+      static bool fm_band(byte mode){
+       #ifdef Si47xx_FM_ONLY
+         return true;
+       #elif defined(Si47xx_AM_ONLY)
+         return false;
+       #else
+         return mode==FM;
+       #endif
+      }
+      #ifdef Si47xx_COMMAND_QUEUE
+      /* Non-blocking command queue.  Ring buffer of commands waiting to be sent. */
+      typedef struct QueuedCommand {
+         byte command[CMD_MAX_LENGTH];
+         byte length;           //Length of command
+         byte response_length;  //Number of response bytes to read
+         CommandCallback callback;
+      } QueuedCommand;
+      QueuedCommand _queue[Si47xx_COMMAND_QUEUE];
+      byte _queue_head;           //Index of first (active) command
+      byte _queue_count;          //Number of commands in queue
+      bool _queue_active;         //True if first command has been sent to radio
+      unsigned long _queue_start; //Time active command was sent in ms
+      #endif
+      #ifdef Si47xx_INTERRUPT_HANDLERS
+      /* Handlers called by dispatchInterrupts() */
+      struct {
+         byte mask;                //Interrupts handled
+         InterruptHandler handler;
+      } _handlers[Si47xx_INTERRUPT_HANDLERS];
+      byte _handler_count;        //Number of valid entries in _handlers[]
+      bool _error_pending;        //Radio rejected a command since last dispatch
+      #endif
+      #if Si47xx_PROPERTY_CACHE
+      /* Shadow copy of radio properties */
+      struct {
+         word property;
+         word value;
+      } _cache[Si47xx_PROPERTY_CACHE];
+      byte _cache_count;          //Number of valid entries in _cache[]
+      byte _cache_next;           //Entry to replace when _cache[] is full
+      word _at_default;           //Properties with known default values untouched since POWER_UP
+      word _cache_hits;           //Property requests handled by cache
+      word _cache_misses;         //Property requests sent to radio
+      #endif
       /* Working buffer that can be used to build a command packet or get a response. */
       byte _buffer[CMD_MAX_LENGTH];  //Length must be CMD_MAX_LENGTH or more
       /* Set radio's volume */
       void set_volume(void);
       /* Do TUNE_STATUS command.  Returns radio's current frequency. */
       word tune_status(byte arg);
+      /* Do TUNE_FREQ command.  new_station false keeps the station info, for checkAF(). */
+      void tune_frequency(word frequency, byte arg, bool new_station=true);
       /* Do SEEK_START command. */
       void seek_start(byte arg);
+      #ifndef Si47xx_AM_ONLY
       /* Returns true if station using RBDS, false if using RDS */
       bool check_if_RBDS(void);
+      #endif
+      /* Update library state after radio has finished given command. */
+      void track_command(const byte *command, byte result);
+      #if Si47xx_PROPERTY_CACHE
+      /* Get property's value from cache or radio's defaults.  Returns false if not known. */
+      bool lookup_property(word property, word *value);
+      /* Returns index of property in _cache[], or a value >= _cache_count if not found. */
+      byte find_property(word property);
+      /* Save property value in _cache[]. */
+      void cache_property(word property, word value);
+      #endif
+      /* Send GET_INT_STATUS and save radio's interrupts.  Returns result of command. */
+      byte read_interrupts(void);
+      /* Write command packet to radio without waiting for CTS. */
+      void send_packet(const byte *command, byte length);
+      /* Wait for CTS after a command.  Returns RADIO_OK, RADIO_ERROR, or RADIO_TIMEOUT. */
+      byte wait_cts(word timeout);
 };
 
 #endif
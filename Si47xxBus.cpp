@@ -0,0 +1,439 @@
+/* Arduino Si4735 Library, bus classes.
+ * SPI and I2C code originally part of Si4735.cpp.
+ * See Si4735.cpp for authors and history.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ * See Si47xxBus.h for a description of the bus classes.
+ */
+
+#include "Si4735.h"
+#ifdef ARDUINO
+ #ifdef Si47xx_SPI
+  #include "SPI.h"
+ #else
+  #include "Wire.h"
+ #endif
+#endif
+#include <string.h>
+
+/******************************************************************************
+*   All buses                                                                 *
+******************************************************************************/
+
+// Wait for the radio without using the bus.
+void Si47xxBus::wait(unsigned long us){
+   //delayMicroseconds() is only accurate up to 16383 µs
+   if(us >= 1000) delay(us/1000);
+   delayMicroseconds(us%1000);
+}
+
+#if defined(Si47xx_SPI) || !defined(ARDUINO)
+/******************************************************************************
+*   SPI framing                                                               *
+******************************************************************************/
+
+// SPI control bytes.  See "Si47xx Programming Guide."
+enum {
+   SPI_WRITE_COMMAND=0x48,  //Write 8 byte command packet
+   SPI_READ_STATUS  =0xA0,  //Read status byte
+   SPI_READ_RESPONSE=0xE0   //Read 16 byte response
+};
+
+// Builds the transaction that writes a command packet.  Returns its length.
+static byte spi_command_frame(byte *frame, const byte *command, byte length){
+   frame[0]=SPI_WRITE_COMMAND;
+   memcpy(frame+1, command, length);
+   //Radio requires we write exactly 8 bytes in SPI mode.
+   //Pad the end of packet with 0.
+   memset(frame+1+length, 0, CMD_MAX_LENGTH-length);
+   return 1+CMD_MAX_LENGTH;
+}
+
+// Builds the transaction that reads a response of given length.  Returns its length.
+static byte spi_response_frame(byte *frame, byte length){
+ #ifndef Si47xx_SPI_SHORT_READS
+   //Programming guide reads exactly 16 bytes in SPI mode.
+   //Remaining bytes are thrown out.
+   length=RESP_MAX_LENGTH;
+ #endif
+   frame[0]=SPI_READ_RESPONSE;
+   memset(frame+1, 0, length);
+   return 1+length;
+}
+
+// Builds the transaction that reads the status byte.  Returns its length.
+static byte spi_status_frame(byte *frame){
+   frame[0]=SPI_READ_STATUS;
+   frame[1]=0;
+   return 2;
+}
+#endif
+
+#ifdef ARDUINO
+/******************************************************************************
+*   Radio attached to Arduino pins                                            *
+******************************************************************************/
+
+// Default bus object
+Si47xxDefaultBus radioBus;
+
+#ifndef __AVR__
+// Interrupt flag
+static volatile bool interrupt_signal=false;
+
+// Interrupt handler for ARM based Arduinos.
+static void interrupt_handler(){
+   //Tell interruptReceived() that interrupt signal received from radio
+   interrupt_signal=true;
+}
+#endif
+
+// Applies power to and resets the radio.
+// See sections 6 "Control Interface" and 7 "Powerup" in Si47xx Programming Guide
+// and Table 4 "Reset Timing Characteristics" in Si4734/35-C40 data sheet.
+// ***** PROTECTED *****
+void Si47xxHardwareBus::reset_radio(){
+   pinMode(RADIO_POWER_PIN, OUTPUT);
+   pinMode(RADIO_RESET_PIN, OUTPUT);
+   //Hard reset radio
+   digitalWrite(RADIO_RESET_PIN, LOW);
+   //At this point, power may be on or off, depending on when we are called.
+   //Remove power from radio
+   digitalWrite(RADIO_POWER_PIN, LOW);
+ #if 00  // <---Kill driving RADIO_INT_PIN
+   //DANGER: We cannot output a high signal on the RADIO_INT_PIN if a unidirectional
+   //level shifter is used on the INT pin.  Breakout board users should use a 10 kΩ
+   //pull-up resistor (to 3.3V) to select SPI, just like the shield does.
+ #ifdef Si47xx_SPI
+   //Tell radio to use SPI mode.  INT pin is read by radio when RESET pin rises.
+   //Note: The SparkFun Arduino shield already provides a 10 kΩ pull-up resistor
+   //on the GPO2/INT pin, which makes this step unnecessary for the shield.
+   //Driving this pin is only useful for breakout board users who are using a
+   //bidirectional level shifter or do not need a level shifter.
+   pinMode(RADIO_INT_PIN, OUTPUT);
+   digitalWrite(RADIO_INT_PIN, HIGH);
+ #endif
+ #endif
+   //Give chip a chance to fully power down
+   //Note: We wait here because we have removed power from the chip, it takes
+   //time to discharge the capacitors connected to the radio's power pins, and
+   //circuits don't like it when their power supply makes rapid changes.
+   delay(1);
+   //Note: Reset must be low while applying power.
+   //Apply power to radio
+   digitalWrite(RADIO_POWER_PIN, HIGH);
+   //Note: Power must be stable for 250 µs before releasing reset.
+   //Note: We wait 50 µs longer because capacitors connected to the radio's power
+   //pins take time to charge and also for safety.
+   //Note: Setup time for GPO1 & GPO2 before reset goes high to select the radio's
+   //bus mode is 100 µs.  However, this is less than the 250 µs we must wait anyways.
+   //Note: There may not be any I2C or SPI bus traffic 300 ns before reset goes high.
+   //Wait 250 µs between applying power and releasing reset.
+   delayMicroseconds(250+50);  //Chip requires 250 µs, extra 50 µs for safety
+   //Release reset - radio now does its internal cold power up initialization
+   digitalWrite(RADIO_RESET_PIN, HIGH);
+   //Give chip time to start-up
+   //Note: The hold time for GPO1 & GPO2 after reset goes high is 30 ns.
+   //Note: The data sheet and guide do not indicate a need to wait before receiving
+   //the first command.  However, it's better to wait just a little.
+   delay(1);
+}
+
+// Initializes interrupt pin and external interrupt.
+// ***** PROTECTED *****
+void Si47xxHardwareBus::begin_interrupts(){
+   //Initialize interrupt pin for normal usage with internal pull-up resistor on.
+   //By having the pull-up resistor active, we prevent spurious interrupts if the user
+   //has chosen not to connect the radio's interrupt output to the microcontroller's
+   //interrupt input.
+   #if ARDUINO >= 101
+   pinMode(RADIO_INT_PIN, INPUT_PULLUP);
+   #else
+   pinMode(RADIO_INT_PIN, INPUT);
+   digitalWrite(RADIO_INT_PIN, HIGH);
+   #endif
+   //Set external interrupt's mode to trigger on trailing edge of interrupt pulse.
+   /* It is possible for two or more interrupts to occur at about the same time,
+    * resulting in only one detectable pulse.  To make certain that we get all the
+    * interrupt sources that caused the pulse, we trigger at the end (or rising edge)
+    * of the active-low pulse.
+    */
+ #ifdef __AVR__
+   /* AVR based Arduinos */
+   if(RADIO_EXT_INT<4){
+      EICRA |= RISING<<(RADIO_EXT_INT*2);
+   }else{
+      //Check for Mega or Leonardo
+      #if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__) || defined(__AVR_ATmega32U4__)
+      EICRB |= RISING<<((RADIO_EXT_INT-4)*2);
+      #endif
+   }
+ #else
+   /* ARM based Arduinos - does not use RADIO_EXT_INT */
+   //Install interrupt handler
+   attachInterrupt(RADIO_INT_PIN, interrupt_handler, RISING);
+ #endif
+}
+
+// Removes power from radio and interrupt handler.
+void Si47xxHardwareBus::end(){
+   //Remove power from radio
+   digitalWrite(RADIO_POWER_PIN, LOW);
+ #ifndef __AVR__
+   /* ARM based Arduinos */
+   //Remove interrupt handler
+   detachInterrupt(RADIO_INT_PIN);
+ #endif
+}
+
+// Returns true if an interrupt signal has been received from the radio since the last call.
+bool Si47xxHardwareBus::interruptReceived(){
+   //Check for interrupt signal
+ #ifdef __AVR__
+   if(EIFR & (1<<RADIO_EXT_INT)){
+      //Clear AVR's interrupt flag
+      EIFR = 1<<RADIO_EXT_INT;
+ #else
+   if(interrupt_signal){
+      //Clear interrupt signal flag
+      interrupt_signal=false;
+ #endif
+      return true;
+   }
+   return false;
+}
+
+#ifdef Si47xx_SPI
+/******************************************************************************
+*   SPI bus                                                                   *
+******************************************************************************/
+
+// Initializes SPI bus and radio.
+// If option BEGIN_DO_NOT_INIT_BUS is given, the SPI bus is NOT initialized.
+void Si47xxSPIBus::begin(byte options, byte bus_arg){
+   //Configure the SPI hardware
+   digitalWrite(RADIO_SPI_SS_PIN, HIGH);
+   pinMode(RADIO_SPI_SS_PIN, OUTPUT);
+   //Init SPI, if requested
+   if( !(options & BEGIN_DO_NOT_INIT_BUS) ){
+      SPI.begin();
+      //Note: Max speed of Si4735 clock input is 2.5 MHz.
+      SPI.setClockDivider(bus_arg ? bus_arg : RADIO_SPI_CLOCK_DIV);
+   }
+   reset_radio();
+   begin_interrupts();
+}
+
+// Write command packet.
+void Si47xxSPIBus::writeCommand(const byte *command, byte length){
+   byte frame[SPI_FRAME_MAX];
+   transfer(frame, spi_command_frame(frame, command, length));
+}
+
+// Read response.
+void Si47xxSPIBus::readResponse(byte *response, byte length){
+   byte frame[SPI_FRAME_MAX];
+   transfer(frame, spi_response_frame(frame, length));
+   //Store response in caller's buffer.
+   memcpy(response, frame+1, length);
+}
+
+// Read status byte.
+byte Si47xxSPIBus::readStatus(){
+   byte frame[2];
+   transfer(frame, spi_status_frame(frame));
+   return frame[1];
+}
+
+// Move one transaction.  Bytes received replace those sent.
+// ***** PROTECTED *****
+void Si47xxSPIBus::transfer(byte *frame, byte length){
+   //Select radio on SPI bus.  SS has 15 ns setup time before clock starts.
+   digitalWrite(RADIO_SPI_SS_PIN, LOW);
+
+ #ifdef SPI_HAS_TRANSACTION
+   //Arduino 1.6 or later: Whole transaction in one call
+   SPI.transfer(frame, length);
+ #else
+   for(byte i=0; i<length; i++) frame[i]=SPI.transfer(frame[i]);
+ #endif
+
+   //Deselect radio on SPI bus.  SS has 5 ns hold time after clock ends.
+   digitalWrite(RADIO_SPI_SS_PIN, HIGH);
+}
+
+#else
+/******************************************************************************
+*   I2C bus                                                                   *
+******************************************************************************/
+
+// Initializes I2C bus and radio.
+// If option BEGIN_DO_NOT_INIT_BUS is given, the I2C bus is NOT initialized.
+void Si47xxI2CBus::begin(byte options, byte bus_arg){
+   //Init I2C, if requested
+   //Note: I2C's SCLK must be initialized (that is, high) before reset goes high below.
+   if( !(options & BEGIN_DO_NOT_INIT_BUS) ){
+      Wire.begin();
+   }
+   //Save radio's address
+   _address = bus_arg ? bus_arg : RADIO_I2C_ADDRESS;
+   reset_radio();
+   begin_interrupts();
+}
+
+// Write command packet.
+void Si47xxI2CBus::writeCommand(const byte *command, byte length){
+   //Start I2C packet
+   Wire.beginTransmission(_address);
+   //Send command
+   Wire.write(command, length);
+   //Finish I2C packet
+   Wire.endTransmission();
+}
+
+// Read response.
+void Si47xxI2CBus::readResponse(byte *response, byte length){
+   //Get response
+   byte i = Wire.requestFrom(_address, length);
+   //Store response in caller's buffer.
+   while(i--){
+      *response++ = Wire.read();
+   }
+}
+
+// Read status byte.
+byte Si47xxI2CBus::readStatus(){
+   //Get status byte
+   //Note: Wire class has two methodes for requestFrom(), one for byte args and
+   //one for int args.  Call the byte method for efficiency.
+   Wire.requestFrom(_address, byte(1));  //cast into a 'byte' for efficiency
+   return Wire.read();
+}
+
+#endif
+
+#else  //Host computer
+/******************************************************************************
+*   Host computer without radio                                               *
+******************************************************************************/
+
+Si47xxHostBus::Si47xxHostBus(){
+   status=CTS_MASK;
+   lastCommandLength=0;
+   commands=0;
+   bytesWritten=0;
+   bytesRead=0;
+   _interrupt=false;
+}
+
+void Si47xxHostBus::begin(byte options, byte bus_arg){
+   //Radio has just been reset
+   status=CTS_MASK;
+   _interrupt=false;
+}
+
+void Si47xxHostBus::end(){
+}
+
+// Save command packet.
+void Si47xxHostBus::writeCommand(const byte *command, byte length){
+   memcpy(lastCommand, command, length);
+   lastCommandLength=length;
+   ++commands;
+   bytesWritten+=length;
+}
+
+// Return status byte followed by zeros.
+void Si47xxHostBus::readResponse(byte *response, byte length){
+   if(!length) return;
+   response[0]=status;
+   memset(response+1, 0, length-1);
+   bytesRead+=length;
+}
+
+byte Si47xxHostBus::readStatus(){
+   ++bytesRead;
+   return status;
+}
+
+bool Si47xxHostBus::interruptReceived(){
+   bool received=_interrupt;
+   _interrupt=false;
+   return received;
+}
+
+void Si47xxHostBus::raiseInterrupt(){
+   _interrupt=true;
+}
+
+/******************************************************************************
+*   SPI bus mock for host computers                                           *
+******************************************************************************/
+
+Si47xxSPIMock::Si47xxSPIMock(){
+   blockTransfers=true;
+   lastFrameLength=0;
+   clearTransfers();
+}
+
+void Si47xxSPIMock::clearTransfers(){
+   transfers=0;
+   memset(transferSizes, 0, sizeof(transferSizes));
+}
+
+// Save command packet and record its transaction.
+void Si47xxSPIMock::writeCommand(const byte *command, byte length){
+   byte frame[SPI_FRAME_MAX];
+   transfer(frame, spi_command_frame(frame, command, length));
+   memcpy(lastCommand, command, length);
+   lastCommandLength=length;
+   ++commands;
+}
+
+// Return status byte followed by zeros.
+void Si47xxSPIMock::readResponse(byte *response, byte length){
+   byte frame[SPI_FRAME_MAX];
+   transfer(frame, spi_response_frame(frame, length));
+   memcpy(response, frame+1, length);
+}
+
+byte Si47xxSPIMock::readStatus(){
+   byte frame[2];
+   transfer(frame, spi_status_frame(frame));
+   return frame[1];
+}
+
+// Record transaction and answer as the radio would.
+// ***** PRIVATE *****
+void Si47xxSPIMock::transfer(byte *frame, byte length){
+   memcpy(lastFrame, frame, length);
+   lastFrameLength=length;
+   if(blockTransfers){
+      ++transfers;
+      ++transferSizes[length];
+   }else{
+      transfers+=length;
+      transferSizes[1]+=length;
+   }
+   //Radio sends nothing during control byte or command
+   if(frame[0]==SPI_WRITE_COMMAND){
+      bytesWritten+=length;
+      return;
+   }
+   bytesWritten+=1;  //Control byte
+   bytesRead+=length-1;
+   frame[1]=status;
+   memset(frame+2, 0, length-2);
+}
+
+#endif
@@ -0,0 +1,179 @@
+/* Arduino Si4735 Library, bus interface.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * This file is included by Si4735.h.  Do not include it directly.
+ *
+ * The Si4735 class talks to the radio chip through a Si47xxBus object.  The bus object
+ * moves command packets, responses, and status bytes between the library and the radio,
+ * controls the radio's power and reset pins, and reports the radio's interrupt signal.
+ *
+ * The library provides these bus classes:
+ * • Si47xxSPIBus - Radio on SPI bus.  Used when the Si47xx_SPI macro is defined.
+ * • Si47xxI2CBus - Radio on I2C bus.  Used when the Si47xx_SPI macro is not defined.
+ * • Si47xxHostBus - No radio.  For host computers such as Linux.  See Si47xxHost.h.
+ * • Si47xxSPIMock - No radio.  Records how Si47xxSPIBus would use the SPI hardware.
+ * • Si47xxSim - Simulated radio for host computers.  See Si47xxSim.h.
+ * Because of the way the Arduino software finds libraries, only one of the SPI and I2C
+ * classes is compiled.  It is created automatically and used by default.
+ *
+ * To use some other bus or board, derive a class from Si47xxBus and pass an object of
+ * that class to the Si4735 constructor.
+ */
+
+#ifndef Si47xxBus_h
+#define Si47xxBus_h
+
+// Longest SPI transaction: control byte and 16 byte response
+enum {SPI_FRAME_MAX=1+RESP_MAX_LENGTH};
+
+class Si47xxBus {
+   public:
+      /* Initializes the bus, applies power to the radio, resets it, and prepares the
+       * radio's interrupt signal.  Called by Si4735::begin().
+       * Parameters are those given to Si4735::begin().
+       */
+      virtual void begin(byte options, byte bus_arg)=0;
+
+      /* Removes power from radio.  Called by Si4735::end(). */
+      virtual void end(void)=0;
+
+      /* Writes a command packet to the radio.  Does not wait for CTS.
+       * length is 1 to CMD_MAX_LENGTH.
+       */
+      virtual void writeCommand(const byte *command, byte length)=0;
+
+      /* Reads a response from the radio.  The first byte is the status byte.
+       * length is 1 to RESP_MAX_LENGTH.
+       */
+      virtual void readResponse(byte *response, byte length)=0;
+
+      /* Reads the radio's status byte. */
+      virtual byte readStatus(void)=0;
+
+      /* Returns true if the radio's interrupt signal was received since the last call. */
+      virtual bool interruptReceived(void)=0;
+
+      /* Waits us µs while the radio works on a command, without using the bus.  Called by
+       * sendCommand() when the Si47xx_CTS_DELAY macro is defined.  The default calls
+       * delay() and delayMicroseconds().
+       */
+      virtual void wait(unsigned long us);
+};
+
+#ifdef ARDUINO
+// Base class for radios attached to an Arduino's pins.  Handles the radio's power,
+// reset, and interrupt pins.  Pin assignments are given in Si4735.h.
+class Si47xxHardwareBus : public Si47xxBus {
+   public:
+      virtual void end(void);
+      virtual bool interruptReceived(void);
+   protected:
+      /* Applies power to and resets the radio. */
+      void reset_radio(void);
+      /* Sets up interrupt pin. */
+      void begin_interrupts(void);
+};
+
+#ifdef Si47xx_SPI
+// Radio on SPI bus.
+// begin()'s bus_arg gives the clock divider to pass to SPI.setClockDivider().
+// Each transaction (control byte and data) is built in one buffer and moved by one call
+// to transfer().  With Arduino 1.6 or later, transfer() moves the buffer with a single
+// SPI.transfer() block call.  To use a board's DMA, derive a class and override transfer().
+class Si47xxSPIBus : public Si47xxHardwareBus {
+   public:
+      virtual void begin(byte options, byte bus_arg);
+      virtual void writeCommand(const byte *command, byte length);
+      virtual void readResponse(byte *response, byte length);
+      virtual byte readStatus(void);
+   protected:
+      /* Selects radio, sends length bytes of frame, and deselects radio.  Bytes received
+       * replace those sent.  length is 2 to SPI_FRAME_MAX.  Must not return until the
+       * transfer has finished.
+       */
+      virtual void transfer(byte *frame, byte length);
+};
+typedef Si47xxSPIBus Si47xxDefaultBus;
+#else
+// Radio on I2C bus.
+// begin()'s bus_arg gives the radio's I2C address.
+class Si47xxI2CBus : public Si47xxHardwareBus {
+   public:
+      virtual void begin(byte options, byte bus_arg);
+      virtual void writeCommand(const byte *command, byte length);
+      virtual void readResponse(byte *response, byte length);
+      virtual byte readStatus(void);
+   private:
+      byte _address;  //Radio's I2C address
+};
+typedef Si47xxI2CBus Si47xxDefaultBus;
+#endif
+
+// Bus used by Si4735 objects created without a bus argument.
+extern Si47xxDefaultBus radioBus;
+
+#else  //Host computer
+
+// Bus for host computers without a radio.  The radio always sets CTS immediately and
+// every response is zero except for the status byte.  Keeps a copy of the last command
+// and counts the bytes moved across the bus.  Derive from this class to script a fake
+// radio's responses.
+class Si47xxHostBus : public Si47xxBus {
+   public:
+      Si47xxHostBus();
+      virtual void begin(byte options, byte bus_arg);
+      virtual void end(void);
+      virtual void writeCommand(const byte *command, byte length);
+      virtual void readResponse(byte *response, byte length);
+      virtual byte readStatus(void);
+      virtual bool interruptReceived(void);
+      /* Simulate the radio's interrupt signal. */
+      void raiseInterrupt(void);
+
+      byte status;                          //Status byte returned to library
+      byte lastCommand[CMD_MAX_LENGTH];     //Last command packet written
+      byte lastCommandLength;               //Length of last command packet
+      unsigned long commands;               //Number of command packets written
+      unsigned long bytesWritten;           //Number of bytes written to radio
+      unsigned long bytesRead;              //Number of bytes read from radio
+   private:
+      bool _interrupt;                      //True if interrupt signal pending
+};
+
+// SPI bus for host computers without a radio.  Builds every transaction exactly as
+// Si47xxSPIBus does and records the calls it would make to the SPI hardware: one per
+// transaction, or one per byte when blockTransfers is false, as with Arduino software
+// older than 1.6.  Answers like Si47xxHostBus.  bytesWritten and bytesRead count bytes
+// on the SPI bus, including control bytes, padding, and unused response bytes.
+class Si47xxSPIMock : public Si47xxHostBus {
+   public:
+      Si47xxSPIMock();
+      virtual void writeCommand(const byte *command, byte length);
+      virtual void readResponse(byte *response, byte length);
+      virtual byte readStatus(void);
+      /* Zeroes transfers and transferSizes. */
+      void clearTransfers(void);
+
+      bool blockTransfers;                  //Move each transaction in one call
+      unsigned long transfers;              //Calls to the SPI hardware
+      unsigned long transferSizes[SPI_FRAME_MAX+1];  //Calls by number of bytes moved
+      byte lastFrame[SPI_FRAME_MAX];        //Bytes sent by last transaction
+      byte lastFrameLength;                 //Length of last transaction
+   private:
+      void transfer(byte *frame, byte length);
+};
+
+#endif
+
+#endif
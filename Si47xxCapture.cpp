@@ -0,0 +1,73 @@
+/* Arduino Si4735 Library, RDS capture files.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ * See Si47xxCapture.h for a description of the capture format.
+ */
+
+#include "Si47xxCapture.h"
+
+#ifndef ARDUINO
+
+Si47xxCaptureFile::Si47xxCaptureFile(){
+   _file=0;
+}
+
+Si47xxCaptureFile::~Si47xxCaptureFile(){
+   close();
+}
+
+bool Si47xxCaptureFile::create(const char *path){
+   close();
+   _file=fopen(path, "wb");
+   if(!_file) return false;
+   byte header[RDS_CAPTURE_HEADER_LENGTH];
+   memcpy(header, RDS_CAPTURE_MAGIC, 3);
+   header[3]=RDS_CAPTURE_VERSION;
+   if(fwrite(header, 1, sizeof(header), _file)!=sizeof(header)){
+      close();
+      return false;
+   }
+   return true;
+}
+
+bool Si47xxCaptureFile::open(const char *path){
+   close();
+   _file=fopen(path, "rb");
+   if(!_file) return false;
+   byte header[RDS_CAPTURE_HEADER_LENGTH];
+   if(fread(header, 1, sizeof(header), _file)!=sizeof(header) ||
+    memcmp(header, RDS_CAPTURE_MAGIC, 3)!=0 || header[3]!=RDS_CAPTURE_VERSION){
+      close();
+      return false;
+   }
+   return true;
+}
+
+void Si47xxCaptureFile::close(){
+   if(_file) fclose(_file);
+   _file=0;
+}
+
+bool Si47xxCaptureFile::write(const byte *record){
+   return _file && fwrite(record, 1, RDS_RECORD_LENGTH, _file)==RDS_RECORD_LENGTH;
+}
+
+bool Si47xxCaptureFile::read(byte *record){
+   return _file && fread(record, 1, RDS_RECORD_LENGTH, _file)==RDS_RECORD_LENGTH;
+}
+
+void Si47xxCaptureFile::rewind(){
+   if(_file) fseek(_file, RDS_CAPTURE_HEADER_LENGTH, SEEK_SET);
+}
+
+#endif
@@ -0,0 +1,81 @@
+/* Arduino Si4735 Library, RDS capture files.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * An RDS capture stream is a 4 byte header followed by capture records, each
+ * RDS_RECORD_LENGTH bytes long, exactly as passed to the capture sink (see
+ * setRDSCapture() in Si4735.h):
+ *    Offset  Size  Contents
+ *    ------------------------------------------------
+ *      0      3    "RDS"
+ *      3      1    Format version RDS_CAPTURE_VERSION
+ *      4     14    First record, and so on
+ * On an Arduino, write the header and then each record to Serial, and save the serial
+ * data in a file on the host.  See the "Si4735_RDSCapture" example.
+ *
+ * Si47xxCaptureFile reads and writes capture files on a host computer.  Only available
+ * when the ARDUINO macro is not defined.  Example replay:
+ *    Si47xxCaptureFile file;
+ *    byte record[RDS_RECORD_LENGTH];
+ *    if(file.open("drive.rds")){
+ *       while(file.read(record)) radio.replayRDS(record);
+ *    }
+ */
+
+#ifndef Si47xxCapture_h
+#define Si47xxCapture_h
+
+#include "Si4735.h"
+#ifndef ARDUINO
+ #include <stdio.h>
+#endif
+
+// Capture stream header
+enum {
+   RDS_CAPTURE_VERSION=1,
+   RDS_CAPTURE_HEADER_LENGTH=4
+};
+#define RDS_CAPTURE_MAGIC "RDS"
+
+#ifndef ARDUINO
+class Si47xxCaptureFile {
+   public:
+      Si47xxCaptureFile();
+      ~Si47xxCaptureFile();
+
+      /* Creates a new capture file and writes its header.  Returns false on failure. */
+      bool create(const char *path);
+
+      /* Opens a capture file for reading.  Returns false if the file cannot be read or
+       * its header is wrong.
+       */
+      bool open(const char *path);
+
+      /* Closes the file.  Also done by the destructor. */
+      void close(void);
+
+      /* Appends a record.  Returns false on failure. */
+      bool write(const byte *record);
+
+      /* Reads the next record.  Returns false at end of file. */
+      bool read(byte *record);
+
+      /* Goes back to the first record. */
+      void rewind(void);
+
+   private:
+      FILE *_file;
+};
+#endif
+
+#endif
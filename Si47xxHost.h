@@ -0,0 +1,70 @@
+/* Arduino Si4735 Library, host computer support.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * When the library is compiled without the Arduino software (the ARDUINO macro is not
+ * defined), Si4735.h includes this file instead of <Arduino.h>.  It supplies the small
+ * part of the Arduino API used by the library so that the library can be compiled and
+ * run on a host computer such as Linux.  Example:
+ *    g++ -I. Si4735.cpp RDS.cpp Si47xxBus.cpp my_test.cpp
+ * There is no radio attached to a host computer.  Pass a Si47xxHostBus object (or your
+ * own Si47xxBus class) to the Si4735 constructor instead.
+ */
+
+#ifndef Si47xxHost_h
+#define Si47xxHost_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+enum {LOW=0, HIGH=1};
+enum {INPUT=0, OUTPUT=1, INPUT_PULLUP=2};
+enum {CHANGE=1, FALLING=2, RISING=3};
+
+#define constrain(amt, low, high) ((amt)<(low) ? (low) : ((amt)>(high) ? (high) : (amt)))
+
+// There are no I/O pins on a host computer.
+inline void pinMode(byte, byte){}
+inline void digitalWrite(byte, byte){}
+
+// Monotonic time since an arbitrary origin.
+inline unsigned long micros(){
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (unsigned long)now.tv_sec*1000000UL + now.tv_nsec/1000;
+}
+
+inline unsigned long millis(){
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (unsigned long)now.tv_sec*1000UL + now.tv_nsec/1000000;
+}
+
+inline void delayMicroseconds(unsigned int us){
+   struct timespec wait={0, (long)us*1000L};
+   nanosleep(&wait, 0);
+}
+
+inline void delay(unsigned long ms){
+   struct timespec wait={(time_t)(ms/1000), (long)(ms%1000)*1000000L};
+   nanosleep(&wait, 0);
+}
+
+#endif
@@ -0,0 +1,718 @@
+/* Arduino Si4735 Library, radio chip simulator for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ * See Si47xxSim.h for a description of the simulator.
+ */
+
+#include "Si47xxSim.h"
+
+#ifndef ARDUINO
+#include <string.h>
+
+// Radio's property values after POWER_UP.  Properties not listed default to 0.
+// See "Si47xx Programming Guide".
+static const PropertyValue sim_defaults[]={
+   {PROP_RX_VOLUME,                    MAX_VOLUME},
+   {PROP_FM_DEEMPHASIS,                FM_DEEMPHASIS_ARG_75},
+   {PROP_FM_RSQ_SNR_HI_THRESHOLD,      127},
+   {PROP_FM_RSQ_RSSI_HI_THRESHOLD,     127},
+   {PROP_FM_SEEK_BAND_BOTTOM,          8750},  //87.5 MHz
+   {PROP_FM_SEEK_BAND_TOP,             10790}, //107.9 MHz
+   {PROP_FM_SEEK_FREQ_SPACING,         10},    //100 kHz
+   {PROP_FM_SEEK_TUNE_SNR_THRESHOLD,   3},     //dB
+   {PROP_FM_SEEK_TUNE_RSSI_THRESHOLD,  20},    //dBµV
+   {PROP_AM_RSQ_SNR_HIGH_THRESHOLD,    127},
+   {PROP_AM_RSQ_RSSI_HIGH_THRESHOLD,   127},
+   {PROP_AM_SEEK_BAND_BOTTOM,          520},   //kHz
+   {PROP_AM_SEEK_BAND_TOP,             1710},  //kHz
+   {PROP_AM_SEEK_FREQ_SPACING,         10},    //kHz
+   {PROP_AM_SEEK_TUNE_SNR_THRESHOLD,   5},     //dB
+   {PROP_AM_SEEK_TUNE_RSSI_THRESHOLD,  25},    //dBµV
+};
+
+// Typical time in µs from command received to CTS.  The guide only promises CTS within
+// 300 µs, but most commands finish much sooner.  Status commands are the quickest.
+static const struct {
+   byte command;
+   unsigned long us;
+} sim_command_times[]={
+   {CMD_GET_REV,         40},
+   {CMD_POWER_DOWN,      50},
+   {CMD_SET_PROPERTY,    60},
+   {CMD_GET_PROPERTY,    40},
+   {CMD_GET_INT_STATUS,  20},
+   {CMD_FM_TUNE_FREQ,    60},
+   {CMD_FM_SEEK_START,   60},
+   {CMD_FM_TUNE_STATUS,  40},
+   {CMD_FM_RSQ_STATUS,   40},
+   {CMD_FM_RDS_STATUS,   50},
+   {CMD_AM_TUNE_FREQ,    60},
+   {CMD_AM_SEEK_START,   60},
+   {CMD_AM_TUNE_STATUS,  40},
+   {CMD_AM_RSQ_STATUS,   40}
+};
+
+Si47xxSim::Si47xxSim(){
+   //Typical radio delays.  See "Si47xx Programming Guide" and Si4734/35-C40 data sheet.
+   timing.cts          =300;     //300 µs, guide's limit, for commands not in table
+   timing.powerUp      =110000;  //110 ms with crystal oscillator
+   timing.tuneFM       =60000;   //60 ms
+   timing.tuneAM       =80000;   //80 ms
+   timing.seekChannelFM=60000;   //60 ms per channel
+   timing.seekChannelAM=80000;   //80 ms per channel
+   timing.rdsGroup     =87580;   //104 bits at 1187.5 bps
+   idleTime  =10;
+   noiseRSSI =5;
+   noiseSNR  =0;
+ #ifdef Si47xx_SPI
+   setBusSpeed(2000000);
+ #else
+   setBusSpeed(100000);
+ #endif
+   _now=0;
+   _station_count=0;
+   clearCommandTimes();
+   for(byte i=0; i<sizeof(sim_command_times)/sizeof(sim_command_times[0]); i++){
+      setCommandTime(sim_command_times[i].command, sim_command_times[i].us);
+   }
+   commands=statusReads=responseReads=bytesWritten=bytesRead=0;
+   busyCommands=errors=interrupts=rdsReceived=rdsDropped=0;
+   begin(BEGIN_DEFAULT, 0);
+}
+
+/******************************************************************************
+*   Si47xxBus methods                                                         *
+******************************************************************************/
+
+// Hardware reset.  Radio is in powerdown mode and ready for POWER_UP.
+void Si47xxSim::begin(byte options, byte bus_arg){
+   _powered=false;
+   _function=POWER_UP_ARG1_FUNC_FM;
+   _arg1=0;
+   _cts=true;
+   _cts_time=_now;
+   _err=false;
+   _stc=false;
+   _rsq=_rsq_state=0;
+   _rds=0;
+   _pin=false;
+   _property_count=0;
+   _frequency=0;
+   _tuning=_seeking=false;
+   _seek_limit=false;
+   _fifo_head=_fifo_count=0;
+   _rds_sync=_rds_overflow=false;
+   memset(_response, 0, sizeof(_response));
+   _last_status=status();
+}
+
+// Power removed.
+void Si47xxSim::end(){
+   _powered=false;
+   _tuning=_seeking=false;
+   _last_status=status();
+}
+
+void Si47xxSim::writeCommand(const byte *command, byte length){
+ #ifdef Si47xx_SPI
+   bytesWritten+=1+CMD_MAX_LENGTH;  //Control byte and padded command
+   bus_time(1+CMD_MAX_LENGTH);
+ #else
+   bytesWritten+=1+length;  //Address and command
+   bus_time(1+length);
+ #endif
+   ++commands;
+   update();
+   //Radio ignores commands sent before CTS
+   if(!_cts){
+      ++busyCommands;
+      return;
+   }
+   //Missing arguments are 0
+   byte packet[CMD_MAX_LENGTH];
+   memset(packet, 0, sizeof(packet));
+   memcpy(packet, command, length<CMD_MAX_LENGTH ? length : CMD_MAX_LENGTH);
+   execute(packet, length);
+   update_interrupts();
+}
+
+void Si47xxSim::readResponse(byte *response, byte length){
+ #if defined(Si47xx_SPI) && !defined(Si47xx_SPI_SHORT_READS)
+   bytesWritten+=1;  //Control byte
+   bytesRead+=RESP_MAX_LENGTH;
+   bus_time(1+RESP_MAX_LENGTH);
+ #else  //I2C, or SPI read ended early
+   bytesWritten+=1;  //Address or control byte
+   bytesRead+=length;
+   bus_time(1+length);
+ #endif
+   ++responseReads;
+   update();
+   if(!length) return;
+   response[0]=status();
+   memcpy(response+1, _response+1, length-1);
+}
+
+byte Si47xxSim::readStatus(){
+   bytesWritten+=1;  //Control byte or address
+   bytesRead+=1;
+   bus_time(2);
+   ++statusReads;
+   update();
+   return status();
+}
+
+// Each call is one trip around the caller's polling loop.
+bool Si47xxSim::interruptReceived(){
+   _now+=idleTime;
+   update();
+   bool pin=_pin;
+   _pin=false;
+   return pin;
+}
+
+// Library waits without the bus.  Only the simulated clock moves.
+void Si47xxSim::wait(unsigned long us){
+   advance(us);
+}
+
+/******************************************************************************
+*   Test control                                                              *
+******************************************************************************/
+
+bool Si47xxSim::addStation(byte mode, word frequency, byte RSSI, byte SNR,
+ const Si47xxSimGroup *groups, word count){
+   byte function = mode==FM ? POWER_UP_ARG1_FUNC_FM : POWER_UP_ARG1_FUNC_AM;
+   if(_station_count>=SIM_MAX_STATIONS || find_station(function, frequency)) return false;
+   Station *station=&_stations[_station_count++];
+   station->function=function;
+   station->frequency=frequency;
+   station->RSSI=RSSI;
+   station->SNR=SNR;
+   station->groups=groups;
+   station->count=groups ? count : 0;
+   station->next=0;
+   return true;
+}
+
+bool Si47xxSim::setSignal(byte mode, word frequency, byte RSSI, byte SNR){
+   update();
+   byte function = mode==FM ? POWER_UP_ARG1_FUNC_FM : POWER_UP_ARG1_FUNC_AM;
+   Station *station=find_station(function, frequency);
+   if(!station) return false;
+   station->RSSI=RSSI;
+   station->SNR=SNR;
+   if(station==tuned_station()){
+      check_rsq();
+      update_interrupts();
+   }
+   return true;
+}
+
+void Si47xxSim::clearStations(){
+   _station_count=0;
+}
+
+bool Si47xxSim::injectRDS(const word block[4], byte errors){
+   update();
+   bool stored=push_rds(block, errors);
+   update_interrupts();
+   return stored;
+}
+
+unsigned long Si47xxSim::now(){
+   return _now;
+}
+
+void Si47xxSim::advance(unsigned long us){
+   _now+=us;
+   update();
+}
+
+bool Si47xxSim::setCommandTime(byte command, unsigned long us){
+   for(byte i=0; i<_command_time_count; i++){
+      if(_command_times[i].command==command){
+         _command_times[i].us=us;
+         return true;
+      }
+   }
+   if(_command_time_count>=SIM_MAX_COMMAND_TIMES) return false;
+   _command_times[_command_time_count].command=command;
+   _command_times[_command_time_count].us=us;
+   ++_command_time_count;
+   return true;
+}
+
+void Si47xxSim::clearCommandTimes(){
+   _command_time_count=0;
+}
+
+void Si47xxSim::setBusSpeed(unsigned long hz){
+   _bus_hz=hz ? hz : 1;
+   _bus_fraction=0;
+}
+
+word Si47xxSim::getProperty(word property){
+   byte i;
+   for(i=0; i<_property_count; i++){
+      if(_properties[i].property==property) return _properties[i].value;
+   }
+   for(i=0; i<sizeof(sim_defaults)/sizeof(PropertyValue); i++){
+      if(sim_defaults[i].property==property) return sim_defaults[i].value;
+   }
+   return 0;
+}
+
+word Si47xxSim::frequency(){
+   if(!_seeking) return _frequency;
+   //Replay seek up to the channel being checked now
+   unsigned long channel = fm() ? timing.seekChannelFM : timing.seekChannelAM;
+   unsigned long steps = channel ? (_now-_seek_start)/channel : _seek_steps;
+   if((long)(_now-_seek_start) < 0) steps=0;
+   if(steps>=_seek_steps) return _seek_frequency;
+   word frequency=_frequency;
+   while(steps--) seek_step(&frequency, _seek_arg & SEEK_START_ARG1_SEEK_UP,
+    _seek_arg & SEEK_START_ARG1_WRAP);
+   return frequency;
+}
+
+/******************************************************************************
+*   Simulated radio                                                           *
+******************************************************************************/
+
+// Advance clock by time needed to move given number of bytes across bus.
+// ***** PRIVATE *****
+void Si47xxSim::bus_time(byte bytes){
+ #ifdef Si47xx_SPI
+   unsigned long bits=bytes*8UL;
+ #else
+   unsigned long bits=bytes*9UL;  //8 data bits and ACK
+ #endif
+   _bus_fraction+=bits*1000000UL;
+   _now+=_bus_fraction/_bus_hz;
+   _bus_fraction%=_bus_hz;
+}
+
+// Do everything the radio would have done by now.
+// ***** PRIVATE *****
+void Si47xxSim::update(){
+   if(!_cts && (long)(_now-_cts_time) >= 0) _cts=true;
+   if(_tuning && (long)(_now-_stc_time) >= 0) finish_tune();
+   //Receive RDS groups from tuned station
+   Station *station;
+   if(_powered && !_tuning && timing.rdsGroup && (station=tuned_station()) && station->count){
+      while((long)(_now-_rds_time) >= 0){
+         const Si47xxSimGroup *group=&station->groups[station->next];
+         if(++station->next>=station->count) station->next=0;
+         push_rds(group->block, group->errors);
+         _rds_time+=timing.rdsGroup;
+      }
+   }
+   update_interrupts();
+}
+
+// Pulse interrupt pin when an enabled interrupt turns on.
+// ***** PRIVATE *****
+void Si47xxSim::update_interrupts(){
+   byte current=status();
+   byte enabled=getProperty(PROP_GPO_IEN);
+   if(_arg1 & POWER_UP_ARG1_CTSIEN) enabled|=CTS_MASK;
+   if(_powered && (_arg1 & POWER_UP_ARG1_GPO2OEN) && (current & ~_last_status & enabled)){
+      _pin=true;
+      ++interrupts;
+   }
+   _last_status=current;
+}
+
+// Returns radio's status byte.
+// ***** PRIVATE *****
+byte Si47xxSim::status(){
+   byte status=0;
+   if(_cts) status|=CTS_MASK;
+   if(_err) status|=ERR_MASK;
+   if(!_powered) return status;
+   if(_stc) status|=STC_MASK;
+   if(_rsq & getProperty(band_property(PROP_FM_RSQ_INT_SOURCE))) status|=RSQ_MASK;
+   if(fm() && (_rds & getProperty(PROP_FM_RDS_INT_SOURCE))) status|=RDS_MASK;
+   return status;
+}
+
+// Carry out given command.  Command has CMD_MAX_LENGTH bytes.
+// ***** PRIVATE *****
+void Si47xxSim::execute(const byte *command, byte length){
+   memset(_response, 0, sizeof(_response));
+   _err=false;
+   _cts=false;
+   _cts_time=_now+command_time(command[0]);
+
+   //Only POWER_UP is accepted in powerdown mode
+   if(!_powered && command[0]!=CMD_POWER_UP) goto error;
+   //FM and AM commands must match radio's function
+   if((command[0] & 0xF0)==0x20 && !fm()) goto error;
+   if((command[0] & 0xF0)==0x40 && fm()) goto error;
+
+   switch(command[0]){
+   case CMD_POWER_UP:
+      if(_powered) goto error;
+      power_up(command[1]);
+      if(!_powered) goto error;
+      break;
+   case CMD_POWER_DOWN:
+      _powered=false;
+      _tuning=_seeking=false;
+      break;
+   case CMD_GET_REV:
+      //Si4735-D60
+      _response[1]=35;   //Part number
+      _response[2]='6';  //Firmware major revision
+      _response[3]='0';  //Firmware minor revision
+      _response[6]='6';  //Component major revision
+      _response[7]='0';  //Component minor revision
+      _response[8]='D';  //Chip revision
+      break;
+   case CMD_SET_PROPERTY:
+      set_property(MAKE_WORD(command[2], command[3]), MAKE_WORD(command[4], command[5]));
+      break;
+   case CMD_GET_PROPERTY:{
+      word value=getProperty(MAKE_WORD(command[2], command[3]));
+      _response[2]=value>>8;
+      _response[3]=value&0xFF;
+      break;
+   }
+   case CMD_GET_INT_STATUS:
+      break;
+   case CMD_FM_TUNE_FREQ:
+   case CMD_AM_TUNE_FREQ:{
+      word frequency=MAKE_WORD(command[2], command[3]);
+      if(fm() ? frequency<6400 || frequency>10800 : frequency<149 || frequency>23000) goto error;
+      tune(frequency);
+      break;
+   }
+   case CMD_FM_SEEK_START:
+   case CMD_AM_SEEK_START:
+      seek(command[1]);
+      break;
+   case CMD_FM_TUNE_STATUS:
+   case CMD_AM_TUNE_STATUS:
+      tune_status(command[1]);
+      break;
+   case CMD_FM_RSQ_STATUS:
+   case CMD_AM_RSQ_STATUS:
+      rsq_status(command[1]);
+      break;
+   case CMD_FM_RDS_STATUS:
+      rds_status(command[1]);
+      break;
+   default:
+      goto error;
+   }
+   return;
+
+   error:
+   _err=true;
+   ++errors;
+}
+
+// Time from command received to CTS.
+// ***** PRIVATE *****
+unsigned long Si47xxSim::command_time(byte command){
+   for(byte i=0; i<_command_time_count; i++){
+      if(_command_times[i].command==command) return _command_times[i].us;
+   }
+   return timing.cts;
+}
+
+// POWER_UP command.
+// ***** PRIVATE *****
+void Si47xxSim::power_up(byte arg1){
+   byte function=arg1 & 0x0F;
+   if(function!=POWER_UP_ARG1_FUNC_FM && function!=POWER_UP_ARG1_FUNC_AM) return;
+   _powered=true;
+   _function=function;
+   _arg1=arg1;
+   _cts_time=_now+timing.powerUp;
+   //All properties return to their defaults
+   _property_count=0;
+   _stc=false;
+   _rsq=_rsq_state=0;
+   _rds=0;
+   _tuning=_seeking=false;
+   _seek_limit=false;
+   _frequency=getProperty(band_property(PROP_FM_SEEK_BAND_BOTTOM));
+   _fifo_head=_fifo_count=0;
+   _rds_sync=_rds_overflow=false;
+}
+
+// TUNE_FREQ command.
+// ***** PRIVATE *****
+void Si47xxSim::tune(word frequency){
+   _frequency=frequency;
+   _stc=false;
+   _tuning=true;
+   _seeking=false;
+   _seek_limit=false;
+   _stc_time=_cts_time + (fm() ? timing.tuneFM : timing.tuneAM);
+   _fifo_count=0;
+   _rds_sync=false;
+}
+
+// SEEK_START command.  The whole seek is worked out now.  frequency() replays it.
+// ***** PRIVATE *****
+void Si47xxSim::seek(byte arg1){
+   bool up   = arg1 & SEEK_START_ARG1_SEEK_UP;
+   bool wrap = arg1 & SEEK_START_ARG1_WRAP;
+   word spacing=getProperty(band_property(PROP_FM_SEEK_FREQ_SPACING));
+   if(!spacing) spacing=1;
+   word channels=(getProperty(band_property(PROP_FM_SEEK_BAND_TOP)) -
+                  getProperty(band_property(PROP_FM_SEEK_BAND_BOTTOM)))/spacing + 1;
+   word frequency=_frequency;
+   word steps=0;
+   bool limit=false;
+   //Check each channel until a valid station is found
+   while(1){
+      ++steps;
+      if(!seek_step(&frequency, up, wrap)){
+         limit=true;  //Hit band limit
+         break;
+      }
+      if(valid(frequency)) break;
+      if(steps>=channels){
+         limit=true;  //Wrapped back to starting channel
+         break;
+      }
+   }
+   _seek_arg=arg1;
+   _seek_steps=steps;
+   _seek_frequency=frequency;
+   _seek_limit=limit;
+   _seek_start=_cts_time;
+   _stc_time=_cts_time + steps*(fm() ? timing.seekChannelFM : timing.seekChannelAM);
+   _stc=false;
+   _tuning=_seeking=true;
+   _fifo_count=0;
+   _rds_sync=false;
+}
+
+// TUNE_STATUS command.
+// ***** PRIVATE *****
+void Si47xxSim::tune_status(byte arg1){
+   if((arg1 & TUNE_STATUS_ARG1_CANCEL_SEEK) && _seeking){
+      //Stop on channel being checked
+      _frequency=frequency();
+      _tuning=_seeking=false;
+      _seek_limit=false;
+   }
+   word frequency=this->frequency();
+   _response[1]=0;
+   if(_seek_limit && !_tuning) _response[1]|=FIELD_TUNE_STATUS_RESP1_SEEK_LIMIT;
+   if(!_tuning && valid(frequency)) _response[1]|=FIELD_TUNE_STATUS_RESP1_VALID;
+   _response[2]=frequency>>8;
+   _response[3]=frequency&0xFF;
+   _response[4]=signal_RSSI(frequency);
+   _response[5]=signal_SNR(frequency);
+   if(arg1 & TUNE_STATUS_ARG1_CLEAR_INT) _stc=false;
+}
+
+// RSQ_STATUS command.
+// ***** PRIVATE *****
+void Si47xxSim::rsq_status(byte arg1){
+   word frequency=this->frequency();
+   _response[1]=_rsq;
+   if(valid(frequency)){
+      _response[2]=FIELD_RSQ_STATUS_RESP2_VALID;
+      if(fm()) _response[3]=FIELD_RSQ_STATUS_RESP3_STEREO | 100;  //Full stereo
+   }
+   _response[4]=signal_RSSI(frequency);
+   _response[5]=signal_SNR(frequency);
+   if(arg1 & RSQ_STATUS_ARG1_CLEAR_INT) _rsq=0;
+}
+
+// FM_RDS_STATUS command.  RESP3 counts the group returned in this response.
+// ***** PRIVATE *****
+void Si47xxSim::rds_status(byte arg1){
+   _response[1]=_rds;
+   if(_rds_sync) _response[2]|=FIELD_RDS_STATUS_RESP2_SYNC;
+   if(_rds_overflow) _response[2]|=FIELD_RDS_STATUS_RESP2_FIFO_OVERFLOW;
+   _rds_overflow=false;
+   if(arg1 & RDS_STATUS_ARG1_CLEAR_INT) _rds=0;
+   if(arg1 & RDS_STATUS_ARG1_CLEAR_FIFO) _fifo_count=0;
+   _response[3]=_fifo_count;
+   if(!_fifo_count) return;
+   const Si47xxSimGroup *group=&_fifo[_fifo_head];
+   for(byte i=0; i<4; i++){
+      _response[4+i*2]=group->block[i]>>8;
+      _response[5+i*2]=group->block[i]&0xFF;
+   }
+   _response[12]=group->errors;
+   //Remove group from FIFO
+   if(!(arg1 & RDS_STATUS_ARG1_STATUS_ONLY)){
+      if(++_fifo_head>=SIM_RDS_FIFO_SIZE) _fifo_head=0;
+      --_fifo_count;
+   }
+}
+
+// Tune or seek has finished.
+// ***** PRIVATE *****
+void Si47xxSim::finish_tune(){
+   if(_seeking) _frequency=_seek_frequency;
+   _tuning=_seeking=false;
+   _stc=true;
+   //New station: Every RSQ condition is new
+   _rsq_state=0;
+   check_rsq();
+   //First RDS group arrives one group time after tuning
+   _rds_time=_stc_time+timing.rdsGroup;
+}
+
+// Latch RSQ interrupt sources whose conditions have become true.
+// ***** PRIVATE *****
+void Si47xxSim::check_rsq(){
+   if(!_powered || _tuning) return;
+   int RSSI=signal_RSSI(_frequency);
+   int SNR=signal_SNR(_frequency);
+   byte state=0;
+   if(RSSI < (signed char)getProperty(band_property(PROP_FM_RSQ_RSSI_LO_THRESHOLD))) state|=RSQ_RSSIL_MASK;
+   if(RSSI > (signed char)getProperty(band_property(PROP_FM_RSQ_RSSI_HI_THRESHOLD))) state|=RSQ_RSSIH_MASK;
+   if(SNR  < (signed char)getProperty(band_property(PROP_FM_RSQ_SNR_LO_THRESHOLD)))  state|=RSQ_SNRL_MASK;
+   if(SNR  > (signed char)getProperty(band_property(PROP_FM_RSQ_SNR_HI_THRESHOLD)))  state|=RSQ_SNRH_MASK;
+   _rsq|=state & ~_rsq_state;
+   _rsq_state=state;
+}
+
+// Put group in RDS FIFO.  Returns false if group was not stored.
+// ***** PRIVATE *****
+bool Si47xxSim::push_rds(const word *block, byte errors){
+   if(!_powered || !fm() || _tuning) return false;
+   word config=getProperty(PROP_FM_RDS_CONFIG);
+   if(!(config & FM_RDS_CONFIG_ARG_ENABLE)) return false;
+   //Drop group if any block has more errors than allowed
+   for(byte shift=0; shift<8; shift+=2){
+      if(((errors>>shift) & 0b11) > ((config>>(8+shift)) & 0b11)) return false;
+   }
+   if(_fifo_count>=SIM_RDS_FIFO_SIZE){
+      _rds_overflow=true;
+      ++rdsDropped;
+      return false;
+   }
+   byte i=_fifo_head+_fifo_count;
+   if(i>=SIM_RDS_FIFO_SIZE) i-=SIM_RDS_FIFO_SIZE;
+   memcpy(_fifo[i].block, block, sizeof(_fifo[i].block));
+   _fifo[i].errors=errors;
+   ++_fifo_count;
+   ++rdsReceived;
+   if(!_rds_sync){
+      _rds_sync=true;
+      _rds|=RDS_SYNC_FOUND_MASK;
+   }
+   word threshold=getProperty(PROP_FM_RDS_INT_FIFO_COUNT);
+   if(_fifo_count>=(threshold ? threshold : 1)) _rds|=RDS_RECEIVED_MASK;
+   return true;
+}
+
+// SET_PROPERTY command.
+// ***** PRIVATE *****
+void Si47xxSim::set_property(word property, word value){
+   byte i;
+   for(i=0; i<_property_count; i++){
+      if(_properties[i].property==property) break;
+   }
+   if(i==_property_count){
+      if(_property_count>=SIM_MAX_PROPERTIES) return;
+      _properties[i].property=property;
+      ++_property_count;
+   }
+   _properties[i].value=value;
+   //RSQ thresholds may have changed
+   check_rsq();
+}
+
+// True if radio is in FM mode.
+// ***** PRIVATE *****
+bool Si47xxSim::fm(){
+   return _function==POWER_UP_ARG1_FUNC_FM;
+}
+
+// Converts FM property into AM property if radio is in AM mode.
+// FM and AM properties have the same layout: 0x1xxx for FM and 0x3xxx for AM.
+// ***** PRIVATE *****
+word Si47xxSim::band_property(word fm_property){
+   return fm() ? fm_property : fm_property+0x2000;
+}
+
+// Moves frequency one channel up or down.  Returns false if band limit reached
+// without wrap.
+// ***** PRIVATE *****
+bool Si47xxSim::seek_step(word *frequency, bool up, bool wrap){
+   word bottom =getProperty(band_property(PROP_FM_SEEK_BAND_BOTTOM));
+   word top    =getProperty(band_property(PROP_FM_SEEK_BAND_TOP));
+   word spacing=getProperty(band_property(PROP_FM_SEEK_FREQ_SPACING));
+   if(!spacing) spacing=1;
+   if(up){
+      if(*frequency+spacing > top){
+         if(!wrap){
+            *frequency=top;
+            return false;
+         }
+         *frequency=bottom;
+      }else{
+         *frequency+=spacing;
+      }
+   }else{
+      if(*frequency < bottom+spacing){
+         if(!wrap){
+            *frequency=bottom;
+            return false;
+         }
+         *frequency=top;
+      }else{
+         *frequency-=spacing;
+      }
+   }
+   return true;
+}
+
+// True if seek would stop on given frequency.
+// ***** PRIVATE *****
+bool Si47xxSim::valid(word frequency){
+   return signal_RSSI(frequency) >= getProperty(band_property(PROP_FM_SEEK_TUNE_RSSI_THRESHOLD)) &&
+          signal_SNR(frequency)  >= getProperty(band_property(PROP_FM_SEEK_TUNE_SNR_THRESHOLD));
+}
+
+// ***** PRIVATE *****
+byte Si47xxSim::signal_RSSI(word frequency){
+   Station *station=find_station(_function, frequency);
+   return station ? station->RSSI : noiseRSSI;
+}
+
+// ***** PRIVATE *****
+byte Si47xxSim::signal_SNR(word frequency){
+   Station *station=find_station(_function, frequency);
+   return station ? station->SNR : noiseSNR;
+}
+
+// ***** PRIVATE *****
+Si47xxSim::Station *Si47xxSim::find_station(byte function, word frequency){
+   for(byte i=0; i<_station_count; i++){
+      if(_stations[i].function==function && _stations[i].frequency==frequency) return &_stations[i];
+   }
+   return 0;
+}
+
+// Returns station radio is tuned to, or 0 if none.
+// ***** PRIVATE *****
+Si47xxSim::Station *Si47xxSim::tuned_station(){
+   if(!_powered || _tuning) return 0;
+   return find_station(_function, _frequency);
+}
+
+#endif
@@ -0,0 +1,259 @@
+/* Arduino Si4735 Library, radio chip simulator for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Si47xxSim is a bus class (see Si47xxBus.h) that behaves like a Si4735 radio chip.
+ * It lets the library's scanning, RDS, and command queue code be tested and timed on a
+ * host computer without a radio.  Only available when the ARDUINO macro is not defined.
+ *
+ * The simulator models the commands used by this library: POWER_UP, POWER_DOWN, GET_REV,
+ * SET_PROPERTY, GET_PROPERTY, GET_INT_STATUS, FM/AM_TUNE_FREQ, FM/AM_SEEK_START,
+ * FM/AM_TUNE_STATUS, FM/AM_RSQ_STATUS, and FM_RDS_STATUS.  Other commands set ERR.
+ *
+ * Time:  The simulator has its own clock measured in µs.  It does not use the host's
+ * clock.  The clock advances as bytes move across the simulated SPI or I2C bus, and by
+ * idleTime each time the library checks for the interrupt signal.  The radio's CTS and
+ * STC delays are measured on this clock, so a program that waits for the radio sees the
+ * same number of bus transactions it would see on real hardware.  Each command has its
+ * own time to CTS, which may be changed with setCommandTime().  wait(), which the library
+ * calls instead of polling when Si47xx_CTS_DELAY is defined, advances the clock without
+ * sleeping.  Call now() to read the clock and advance() to let simulated time pass.
+ *
+ * Interrupts:  The status byte's STC, RSQ, RDS, and ERR bits follow the radio's rules.
+ * STC is cleared by TUNE_STATUS, RSQ by RSQ_STATUS, and RDS by FM_RDS_STATUS, each with
+ * its INTACK bit.  When a bit enabled by the GPO_IEN property turns on, and POWER_UP
+ * enabled the GPO2/INT pin, interruptReceived() returns true once.
+ *
+ * Stations:  addStation() places a station on a frequency with a fixed RSSI and SNR.
+ * Other frequencies return noiseRSSI and noiseSNR.  Seek stops on a station whose RSSI
+ * and SNR meet the radio's SEEK_TUNE thresholds.  An FM station may be given a list of
+ * RDS groups that it repeats forever at the RDS group rate.  Groups may also be pushed
+ * straight into the RDS FIFO with injectRDS().
+ *
+ * Example:
+ *    Si47xxSim sim;
+ *    Si4735 radio(&sim);
+ *    sim.addStation(FM, 9730, 50, 30, groups, num_groups);
+ *    radio.begin();
+ *    radio.setMode(FM);
+ *    radio.tuneFrequencyAndWait(9730);
+ *    sim.advance(1000000);  //Let one second of RDS arrive
+ *    radio.checkRDS();
+ */
+
+#ifndef Si47xxSim_h
+#define Si47xxSim_h
+
+#include "Si4735.h"
+
+#ifndef ARDUINO
+
+// Simulator limits
+enum {
+   SIM_MAX_STATIONS=64,       //Maximum stations given to addStation()
+   SIM_MAX_PROPERTIES=64,     //Maximum properties changed from their defaults
+   SIM_MAX_COMMAND_TIMES=16,  //Maximum commands given to setCommandTime()
+   SIM_RDS_FIFO_SIZE=25       //Radio's RDS FIFO size in groups
+};
+
+// One RDS group.  errors gives the block error levels in the same format as RESP12
+// of FM_RDS_STATUS.  Use RDS_STATUS_RESP12_BLOCK_x constants from Si4735.h.
+typedef struct Si47xxSimGroup {
+   word block[4];  //Blocks A, B, C, D
+   byte errors;    //Block error levels
+} Si47xxSimGroup;
+
+// Radio delays measured in µs.  See "Si47xx Programming Guide" and data sheets.
+typedef struct Si47xxSimTiming {
+   unsigned long cts;            //Commands without a setCommandTime(): Command received to CTS
+   unsigned long powerUp;        //POWER_UP: Command received to CTS
+   unsigned long tuneFM;         //FM_TUNE_FREQ: CTS to STC
+   unsigned long tuneAM;         //AM_TUNE_FREQ: CTS to STC
+   unsigned long seekChannelFM;  //FM_SEEK_START: Time spent on each channel
+   unsigned long seekChannelAM;  //AM_SEEK_START: Time spent on each channel
+   unsigned long rdsGroup;       //Time to receive one RDS group (104 bits at 1187.5 bps)
+} Si47xxSimTiming;
+
+class Si47xxSim : public Si47xxBus {
+   public:
+      Si47xxSim();
+
+      /* Si47xxBus methods called by the Si4735 class. */
+      virtual void begin(byte options, byte bus_arg);
+      virtual void end(void);
+      virtual void writeCommand(const byte *command, byte length);
+      virtual void readResponse(byte *response, byte length);
+      virtual byte readStatus(void);
+      virtual bool interruptReceived(void);
+      virtual void wait(unsigned long us);
+
+      /* Adds a station.  Returns false if there is no room or the frequency is in use.
+       * Parameters:
+       *  mode - FM, AM, SW, or LW.  AM, SW, and LW stations are the same to the radio.
+       *  frequency - In 10 kHz for FM or kHz for AM, SW, and LW.
+       *  RSSI, SNR - Signal strength in dBµV and signal to noise ratio in dB.
+       *  groups, count - FM only: RDS groups sent by the station over and over.  The
+       *                  array is not copied and must remain valid.  May be 0.
+       */
+      bool addStation(byte mode, word frequency, byte RSSI, byte SNR,
+       const Si47xxSimGroup *groups=0, word count=0);
+
+      /* Changes the RSSI and SNR of a station added by addStation().  If the radio is tuned
+       * to the station, the RSQ interrupt is checked again.  Returns false if not found.
+       */
+      bool setSignal(byte mode, word frequency, byte RSSI, byte SNR);
+
+      /* Removes all stations. */
+      void clearStations(void);
+
+      /* Puts an RDS group in the RDS FIFO now, as if the tuned station sent it.  The group
+       * is dropped if RDS is disabled, if the radio is not in FM mode, or if the block
+       * errors exceed those allowed by the FM_RDS_CONFIG property.
+       * Returns true if the group was put in the FIFO.
+       */
+      bool injectRDS(const word block[4], byte errors=0);
+
+      /* Returns the simulated time in µs. */
+      unsigned long now(void);
+
+      /* Lets time pass on the simulated clock. */
+      void advance(unsigned long us);
+
+      /* Sets the time in µs from command received to CTS for one command.  Starts with
+       * typical times for the commands used by this library.  Commands without a time use
+       * timing.cts, except POWER_UP which always uses timing.powerUp.
+       * Returns false if there is no room.
+       */
+      bool setCommandTime(byte command, unsigned long us);
+
+      /* Removes all times given by setCommandTime(), including the typical times. */
+      void clearCommandTimes(void);
+
+      /* Sets the speed of the simulated bus in Hz.  Defaults to 2 MHz for SPI and 100 kHz
+       * for I2C, as selected by the Si47xx_SPI macro.
+       */
+      void setBusSpeed(unsigned long hz);
+
+      /* Returns the value of a radio property. */
+      word getProperty(word property);
+
+      /* Returns the radio's tuned frequency.  During a seek, this is the channel being checked. */
+      word frequency(void);
+
+      Si47xxSimTiming timing;     //Radio delays.  May be changed at any time.
+      unsigned long idleTime;     //µs added to clock by each interruptReceived() call
+      byte noiseRSSI;             //RSSI where there is no station
+      byte noiseSNR;              //SNR where there is no station
+
+      //Counters.  May be cleared at any time.
+      unsigned long commands;        //Command packets written
+      unsigned long statusReads;     //Status bytes read
+      unsigned long responseReads;   //Responses read
+      unsigned long bytesWritten;    //Bytes written to radio, including bus overhead
+      unsigned long bytesRead;       //Bytes read from radio, including bus overhead
+      unsigned long busyCommands;    //Commands written before CTS.  Ignored by radio.
+      unsigned long errors;          //Commands that set ERR
+      unsigned long interrupts;      //Pulses on the interrupt pin
+      unsigned long rdsReceived;     //RDS groups put in FIFO
+      unsigned long rdsDropped;      //RDS groups lost to a full FIFO
+
+   private:
+      void bus_time(byte bytes);
+      void update(void);
+      void update_interrupts(void);
+      byte status(void);
+      void execute(const byte *command, byte length);
+      unsigned long command_time(byte command);
+      void power_up(byte arg1);
+      void tune(word frequency);
+      void seek(byte arg1);
+      void tune_status(byte arg1);
+      void rsq_status(byte arg1);
+      void rds_status(byte arg1);
+      void finish_tune(void);
+      void check_rsq(void);
+      bool push_rds(const word *block, byte errors);
+      void set_property(word property, word value);
+      bool fm(void);
+      word band_property(word fm_property);
+      bool seek_step(word *frequency, bool up, bool wrap);
+      bool valid(word frequency);
+      byte signal_RSSI(word frequency);
+      byte signal_SNR(word frequency);
+
+      //Simulated clock
+      unsigned long _now;           //Current time in µs
+      unsigned long _bus_hz;        //Bus speed
+      unsigned long _bus_fraction;  //Bus time less than 1 µs, in µs*_bus_hz
+
+      //Radio state
+      bool _powered;                //True after POWER_UP
+      byte _function;               //POWER_UP_ARG1_FUNC_FM or _AM
+      byte _arg1;                   //POWER_UP ARG1
+      bool _cts;                    //Clear To Send
+      unsigned long _cts_time;      //Time CTS will be set
+      bool _err;                    //Last command failed
+      bool _stc;                    //Seek/Tune Complete interrupt
+      byte _rsq;                    //RSQ interrupt sources (RESP1 of RSQ_STATUS)
+      byte _rsq_state;              //RSQ conditions now true.  _rsq is set when they become true.
+      byte _rds;                    //RDS interrupt sources (RESP1 of FM_RDS_STATUS)
+      byte _last_status;            //Interrupt bits seen by last update_interrupts()
+      bool _pin;                    //Interrupt pulse not yet seen by interruptReceived()
+      byte _response[RESP_MAX_LENGTH];  //Response of last command
+      PropertyValue _properties[SIM_MAX_PROPERTIES];  //Properties changed from defaults
+      byte _property_count;
+      struct CommandTime {
+         byte command;
+         unsigned long us;
+      };
+      CommandTime _command_times[SIM_MAX_COMMAND_TIMES];  //Times given by setCommandTime()
+      byte _command_time_count;
+
+      //Tuning
+      word _frequency;              //Tuned frequency, or start of seek
+      bool _tuning;                 //Tune or seek in progress
+      unsigned long _stc_time;      //Time tune or seek will finish
+      unsigned long _seek_start;    //Time seek began
+      bool _seeking;                //True if seek in progress
+      byte _seek_arg;               //SEEK_START ARG1
+      word _seek_steps;             //Channels checked by seek
+      word _seek_frequency;         //Frequency seek will stop on
+      bool _seek_limit;             //Seek stopped at band limit
+
+      //RDS
+      Si47xxSimGroup _fifo[SIM_RDS_FIFO_SIZE];
+      byte _fifo_head;
+      byte _fifo_count;
+      bool _rds_sync;
+      bool _rds_overflow;
+      unsigned long _rds_time;      //Time next RDS group arrives
+
+      //Stations
+      struct Station {
+         byte function;
+         word frequency;
+         byte RSSI;
+         byte SNR;
+         const Si47xxSimGroup *groups;
+         word count;
+         word next;                 //Next group to send
+      };
+      Station _stations[SIM_MAX_STATIONS];
+      byte _station_count;
+      Station *find_station(byte function, word frequency);
+      Station *tuned_station(void);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,336 @@
+/* Arduino Si4735 Library, station database.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ * See Si47xxStations.h for a description of the station database.
+ */
+
+#include "Si47xxStations.h"
+#ifdef __AVR__
+ #include <avr/eeprom.h>
+#endif
+#include <string.h>
+
+// Header at start of storage
+enum {
+   HEADER_MAGIC=0,     //word
+   HEADER_VERSION=2,
+   HEADER_COUNT,
+   HEADER_LAST,
+   HEADER_FAVORITE,
+   HEADER_SIZE
+};
+
+/******************************************************************************
+*   Storage                                                                   *
+******************************************************************************/
+
+#ifdef __AVR__
+Si47xxEEPROM::Si47xxEEPROM(word base){
+   _base=base;
+}
+
+void Si47xxEEPROM::read(word address, void *data, word length){
+   eeprom_read_block(data, (const void *)(_base+address), length);
+}
+
+void Si47xxEEPROM::write(word address, const void *data, word length){
+   //Only write bytes that change to save EEPROM wear
+   eeprom_update_block(data, (void *)(_base+address), length);
+}
+#endif
+
+#ifndef ARDUINO
+Si47xxFileStorage::Si47xxFileStorage(const char *path){
+   //Open existing file, or create new file
+   _file=fopen(path, "r+b");
+   if(!_file) _file=fopen(path, "w+b");
+}
+
+Si47xxFileStorage::~Si47xxFileStorage(){
+   if(_file) fclose(_file);
+}
+
+void Si47xxFileStorage::read(word address, void *data, word length){
+   size_t got=0;
+   if(_file && fseek(_file, address, SEEK_SET)==0){
+      got=fread(data, 1, length, _file);
+   }
+   //Bytes past end of file read as erased EEPROM
+   memset((byte *)data+got, 0xFF, length-got);
+}
+
+void Si47xxFileStorage::write(word address, const void *data, word length){
+   if(!_file || fseek(_file, address, SEEK_SET)!=0) return;
+   fwrite(data, 1, length, _file);
+   fflush(_file);
+}
+#endif
+
+/******************************************************************************
+*   Station database                                                          *
+******************************************************************************/
+
+// Returns true if mode and frequency can be tuned.  Erased or corrupted records are not.
+static bool valid_station(byte mode, word frequency){
+   switch(mode){
+   case FM:
+      return frequency>=6400 && frequency<=10800;  //64-108 MHz
+   case AM:
+   case SW:
+   case LW:
+      return frequency>=149 && frequency<=23000;   //kHz
+   }
+   return false;
+}
+
+Si47xxStationDB::Si47xxStationDB(Si47xxStorage *storage){
+   _storage=storage;
+   _count=0;
+   _last=_favorite=NO_STATION;
+}
+
+// Read database header and station keys from storage.
+void Si47xxStationDB::begin(){
+   byte header[HEADER_SIZE];
+   _storage->read(0, header, sizeof(header));
+   _count=0;
+   _last=_favorite=NO_STATION;
+   if(MAKE_WORD(header[HEADER_MAGIC+1], header[HEADER_MAGIC])==STATION_DB_MAGIC &&
+    header[HEADER_VERSION]==STATION_DB_VERSION){
+      _count=header[HEADER_COUNT];
+      if(_count>STATION_DB_MAX) _count=STATION_DB_MAX;
+      _last=header[HEADER_LAST];
+      _favorite=header[HEADER_FAVORITE];
+   }
+   //Load keys
+   SavedStation station;
+   for(byte i=0; i<_count; i++){
+      _storage->read(address(i), &station, sizeof(station));
+      _frequency[i]=station.frequency;
+      _mode[i]=station.mode;
+      _pi[i]=station.programId;
+   }
+   if(_last>=_count) _last=NO_STATION;
+   if(_favorite>=_count) _favorite=NO_STATION;
+   build_indexes();
+   //Drop invalid records.  From the end, so the station moved into a hole is already checked.
+   for(byte i=_count; i--; ){
+      if(!valid_station(_mode[i], _frequency[i])) remove(i);
+   }
+}
+
+byte Si47xxStationDB::count(){
+   return _count;
+}
+
+bool Si47xxStationDB::get(byte index, SavedStation *station){
+   if(index>=_count) return false;
+   _storage->read(address(index), station, sizeof(*station));
+   return true;
+}
+
+// Save station, replacing station with same mode and frequency.
+// Returns index or NO_STATION if database is full.
+byte Si47xxStationDB::save(const SavedStation *station){
+   if(!valid_station(station->mode, station->frequency)) return NO_STATION;
+   byte index=findFrequency(station->mode, station->frequency);
+   if(index==NO_STATION){
+      //New station
+      if(_count>=STATION_DB_MAX) return NO_STATION;
+      index=_count++;
+   }
+   _storage->write(address(index), station, sizeof(*station));
+   _frequency[index]=station->frequency;
+   _mode[index]=station->mode;
+   _pi[index]=station->programId;
+   write_header();
+   build_indexes();
+   return index;
+}
+
+// Save station radio is tuned to.
+byte Si47xxStationDB::save(Si4735 *radio){
+   SavedStation station;
+   station.mode=radio->getMode();
+   station.frequency=radio->currentFrequency();
+   if(station.mode==RADIO_OFF || !station.frequency) return NO_STATION;
+   //RDS info
+ #ifdef Si47xx_AM_ONLY
+   station.programId=0;
+   station.programType=0;
+   memset(station.programService, ' ', sizeof(station.programService));
+ #else
+   //PI and PS are only saved once received with confidence.  Otherwise 0 and blanks.
+   station.programId = radio->isProgramIdTrusted() ? radio->rds.programId : 0;
+   station.programType=radio->rds.programType;
+   bool trusted=radio->isProgramServiceTrusted();
+   for(byte i=0; i<sizeof(station.programService); i++){
+      char ch=radio->rds.programService[i];
+      station.programService[i] = ch && trusted ? ch : ' ';
+   }
+ #endif
+   //Signal quality
+   RSQMetrics RSQ;
+   radio->getRSQ(&RSQ);
+   station.RSSI=RSQ.RSSI;
+   station.SNR=RSQ.SNR;
+   return save(&station);
+}
+
+// Remove station.  Last station is moved into its place.
+bool Si47xxStationDB::remove(byte index){
+   if(index>=_count) return false;
+   byte moved=--_count;
+   if(index!=moved){
+      SavedStation station;
+      _storage->read(address(moved), &station, sizeof(station));
+      _storage->write(address(index), &station, sizeof(station));
+      _frequency[index]=_frequency[moved];
+      _mode[index]=_mode[moved];
+      _pi[index]=_pi[moved];
+   }
+   //Fix last and favorite
+   if(_last==index) _last=NO_STATION;
+   else if(_last==moved) _last=index;
+   if(_favorite==index) _favorite=NO_STATION;
+   else if(_favorite==moved) _favorite=index;
+   write_header();
+   build_indexes();
+   return true;
+}
+
+void Si47xxStationDB::clear(){
+   _count=0;
+   _last=_favorite=NO_STATION;
+   write_header();
+}
+
+// Binary search of index by mode and frequency.
+byte Si47xxStationDB::findFrequency(byte mode, word frequency){
+   byte low=0, high=_count;
+   while(low<high){
+      byte middle=(low+high)/2;
+      byte i=_by_frequency[middle];
+      if(_mode[i]<mode || (_mode[i]==mode && _frequency[i]<frequency)){
+         low=middle+1;
+      }else{
+         high=middle;
+      }
+   }
+   if(low<_count){
+      byte i=_by_frequency[low];
+      if(_mode[i]==mode && _frequency[i]==frequency) return i;
+   }
+   return NO_STATION;
+}
+
+// Binary search of index by PI code.
+byte Si47xxStationDB::findPI(word programId){
+   //PI of 0 means no RDS
+   if(!programId) return NO_STATION;
+   byte low=0, high=_count;
+   while(low<high){
+      byte middle=(low+high)/2;
+      if(_pi[_by_pi[middle]]<programId){
+         low=middle+1;
+      }else{
+         high=middle;
+      }
+   }
+   if(low<_count && _pi[_by_pi[low]]==programId) return _by_pi[low];
+   return NO_STATION;
+}
+
+byte Si47xxStationDB::byFrequency(byte n){
+   return n<_count ? _by_frequency[n] : NO_STATION;
+}
+
+// Tune radio to station and remember it as the last station.
+bool Si47xxStationDB::recall(Si4735 *radio, byte index){
+   if(index>=_count || !valid_station(_mode[index], _frequency[index])) return false;
+   if(radio->getMode()!=_mode[index]) radio->setMode(_mode[index]);
+   radio->tuneFrequency(_frequency[index]);
+   setLast(index);
+   return true;
+}
+
+bool Si47xxStationDB::recallLast(Si4735 *radio){
+   return recall(radio, _last);
+}
+
+bool Si47xxStationDB::recallFavorite(Si4735 *radio){
+   return recall(radio, _favorite);
+}
+
+byte Si47xxStationDB::getLast(){
+   return _last;
+}
+
+void Si47xxStationDB::setLast(byte index){
+   if(index>=_count) index=NO_STATION;
+   if(index==_last) return;
+   _last=index;
+   _storage->write(HEADER_LAST, &_last, 1);
+}
+
+byte Si47xxStationDB::getFavorite(){
+   return _favorite;
+}
+
+void Si47xxStationDB::setFavorite(byte index){
+   if(index>=_count) index=NO_STATION;
+   if(index==_favorite) return;
+   _favorite=index;
+   _storage->write(HEADER_FAVORITE, &_favorite, 1);
+}
+
+// ***** PRIVATE *****
+word Si47xxStationDB::address(byte index){
+   return HEADER_SIZE + index*sizeof(SavedStation);
+}
+
+// ***** PRIVATE *****
+void Si47xxStationDB::write_header(){
+   byte header[HEADER_SIZE];
+   header[HEADER_MAGIC]  =STATION_DB_MAGIC & 0xFF;
+   header[HEADER_MAGIC+1]=STATION_DB_MAGIC >> 8;
+   header[HEADER_VERSION]=STATION_DB_VERSION;
+   header[HEADER_COUNT]=_count;
+   header[HEADER_LAST]=_last;
+   header[HEADER_FAVORITE]=_favorite;
+   _storage->write(0, header, sizeof(header));
+}
+
+// Sort both indexes with insertion sort.  The database is small.
+// ***** PRIVATE *****
+void Si47xxStationDB::build_indexes(){
+   for(byte n=0; n<_count; n++){
+      //Insert station n into both sorted lists
+      byte i;
+      for(i=n; i>0 && compare_frequency(_by_frequency[i-1], n)>0; i--){
+         _by_frequency[i]=_by_frequency[i-1];
+      }
+      _by_frequency[i]=n;
+      for(i=n; i>0 && _pi[_by_pi[i-1]]>_pi[n]; i--){
+         _by_pi[i]=_by_pi[i-1];
+      }
+      _by_pi[i]=n;
+   }
+}
+
+// ***** PRIVATE *****
+int Si47xxStationDB::compare_frequency(byte a, byte b){
+   if(_mode[a]!=_mode[b]) return _mode[a]<_mode[b] ? -1 : 1;
+   if(_frequency[a]!=_frequency[b]) return _frequency[a]<_frequency[b] ? -1 : 1;
+   return 0;
+}
@@ -0,0 +1,201 @@
+/* Arduino Si4735 Library, station database.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Si47xxStationDB remembers stations across power cycles.  Each station is saved as a
+ * fixed size SavedStation record in a Si47xxStorage object:
+ * • Si47xxEEPROM - AVR's internal EEPROM.  AVR based Arduinos only.
+ * • Si47xxFileStorage - A file.  Host computers only.
+ * To use other storage, derive a class from Si47xxStorage.
+ *
+ * Storage layout (all words are little endian):
+ *    Offset  Size  Contents
+ *    ------------------------------------------------
+ *      0      2    Magic number STATION_DB_MAGIC
+ *      2      1    Format version STATION_DB_VERSION
+ *      3      1    Number of stations
+ *      4      1    Last station recalled, or NO_STATION
+ *      5      1    Favorite station, or NO_STATION
+ *      6     16    First SavedStation record, and so on
+ *
+ * The database keeps two sorted indexes in SRAM, one by mode and frequency and one by
+ * PI code, so findFrequency() and findPI() are binary searches that do not read storage.
+ *
+ * Example:
+ *    Si47xxEEPROM eeprom;
+ *    Si47xxStationDB stations(&eeprom);
+ *    void setup(){
+ *       radio.begin();
+ *       stations.begin();
+ *       if(!stations.recallLast(&radio)) radio.setMode(FM);
+ *    }
+ *    //Later, after RDS has been received:
+ *    stations.save(&radio);
+ */
+
+#ifndef Si47xxStations_h
+#define Si47xxStations_h
+
+#include "Si4735.h"
+#ifndef ARDUINO
+ #include <stdio.h>
+#endif
+
+// Maximum number of stations in a Si47xxStationDB.  Each station uses 8 bytes of SRAM
+// for the indexes.  Change if you want.
+enum {STATION_DB_MAX=16};
+
+// Storage format identification
+enum {
+   STATION_DB_MAGIC=0x5334,  //"4S"
+   STATION_DB_VERSION=1
+};
+
+// Returned by methods that give a station's index when there is no such station.
+enum {NO_STATION=0xFF};
+
+// Station saved in a Si47xxStationDB.  Stored as is, so the size must not change.
+typedef struct SavedStation {
+   word frequency;          //kHz for AM, SW, LW or 10 kHz for FM
+   byte mode;               //FM, AM, SW, or LW
+   byte programType;        //RDS Program Type (PTY) code
+   word programId;          //RDS Program Identification (PI) code, 0 if none
+   char programService[8];  //RDS station name, padded with spaces, not null terminated
+   byte RSSI;               //Received Signal Strength Indication when saved in dBµV
+   byte SNR;                //Signal to Noise Ratio when saved in dB
+} SavedStation;
+
+// Byte addressed non-volatile storage used by Si47xxStationDB.
+class Si47xxStorage {
+   public:
+      /* Read length bytes starting at address into data.  Unwritten bytes read as 0xFF. */
+      virtual void read(word address, void *data, word length)=0;
+
+      /* Write length bytes from data starting at address. */
+      virtual void write(word address, const void *data, word length)=0;
+};
+
+#ifdef __AVR__
+// AVR's internal EEPROM.  Bytes that do not change are not rewritten.
+class Si47xxEEPROM : public Si47xxStorage {
+   public:
+      /* base - First EEPROM address used by the database. */
+      Si47xxEEPROM(word base=0);
+      virtual void read(word address, void *data, word length);
+      virtual void write(word address, const void *data, word length);
+   private:
+      word _base;
+};
+#endif
+
+#ifndef ARDUINO
+// File on a host computer.  The file is created if it does not exist.
+class Si47xxFileStorage : public Si47xxStorage {
+   public:
+      Si47xxFileStorage(const char *path);
+      ~Si47xxFileStorage();
+      virtual void read(word address, void *data, word length);
+      virtual void write(word address, const void *data, word length);
+   private:
+      FILE *_file;
+};
+#endif
+
+class Si47xxStationDB {
+   public:
+      Si47xxStationDB(Si47xxStorage *storage);
+
+      /* Reads the database from storage and builds the indexes.  Storage without a valid
+       * database, such as a new EEPROM, gives an empty database.  Records with a mode or
+       * frequency the radio cannot tune are removed.
+       */
+      void begin(void);
+
+      /* Returns number of stations saved. */
+      byte count(void);
+
+      /* Copies station at given index into given structure.  Returns false if no such station.
+       * Indexes run from 0 to count()-1 and change when a station is removed.
+       */
+      bool get(byte index, SavedStation *station);
+
+      /* Saves the given station.  A station with the same mode and frequency is replaced.
+       * Returns the station's index, or NO_STATION if the database is full or the mode or
+       * frequency is invalid.
+       */
+      byte save(const SavedStation *station);
+
+      /* Saves the station the radio is tuned to, with its RDS info and current RSQ.  PI and
+       * PS are saved only once received with confidence, otherwise 0 and spaces.
+       * Returns the station's index, or NO_STATION if the radio is off or the database is full.
+       */
+      byte save(Si4735 *radio);
+
+      /* Removes station at given index.  The last station takes its index. */
+      bool remove(byte index);
+
+      /* Removes all stations. */
+      void clear(void);
+
+      /* Returns index of station with given mode and frequency, or NO_STATION. */
+      byte findFrequency(byte mode, word frequency);
+
+      /* Returns index of a station with given RDS PI code, or NO_STATION. */
+      byte findPI(word programId);
+
+      /* Returns index of nth station in order of mode and frequency, or NO_STATION.
+       * Use to list stations in order.
+       */
+      byte byFrequency(byte n);
+
+      /* Switches radio to the station's mode, if needed, and tunes to the station.  The
+       * station becomes the last station.  As with tuneFrequency(), the caller should then
+       * wait for the STC interrupt.  Returns false if no such station.
+       */
+      bool recall(Si4735 *radio, byte index);
+
+      /* Recalls the last station recalled.  Returns false if none. */
+      bool recallLast(Si4735 *radio);
+
+      /* Recalls the favorite station.  Returns false if none. */
+      bool recallFavorite(Si4735 *radio);
+
+      /* Get/set the last station and favorite station.  NO_STATION means none. */
+      byte getLast(void);
+      void setLast(byte index);
+      byte getFavorite(void);
+      void setFavorite(byte index);
+
+   private:
+      Si47xxStorage *_storage;
+      byte _count;                        //Number of stations
+      byte _last;                         //Last station recalled
+      byte _favorite;                     //Favorite station
+      /* Keys of each station, kept in SRAM so searches do not read storage */
+      word _frequency[STATION_DB_MAX];
+      word _pi[STATION_DB_MAX];
+      byte _mode[STATION_DB_MAX];
+      /* Station indexes sorted by key */
+      byte _by_frequency[STATION_DB_MAX];
+      byte _by_pi[STATION_DB_MAX];
+      /* Storage address of station's record */
+      word address(byte index);
+      /* Write header to storage */
+      void write_header(void);
+      /* Sort indexes by key */
+      void build_indexes(void);
+      /* Compare stations a and b by mode and frequency.  Returns <0, 0, or >0. */
+      int compare_frequency(byte a, byte b);
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+* Si4735 Benchmark Sketch
+*
+* This sketch measures how long common radio operations take and how many
+* commands they send to the radio.  Use it to compare library versions, bus
+* speeds, and compile time options on your own board.
+*
+* HARDWARE SETUP:
+* This sketch assumes you are using the Si4735 Shield or Breakout Board from
+* SparkFun Electronics with an antenna attached.
+*
+* USING THE SKETCH:
+* Upload the sketch and open the serial terminal at 9600 bps.  Results are
+* printed once as comma separated lines, one line per measurement:
+*    test,mode,microseconds,property_writes,property_writes_skipped
+* property_writes counts SET_PROPERTY commands sent to the radio.
+* property_writes_skipped counts setProperty() calls that did not need the bus
+* because the radio already had the value.  Other commands, such as POWER_UP,
+* and the bytes moved across the bus are not counted here.  For these, see the
+* setMode lines of extras/benchmark/suite.cpp, which runs on a host computer, or
+* define Si47xx_BUS_STATS.
+* Band scans are printed as:
+*    test,mode,milliseconds,stations
+* Stepped scans of the SW band check every channel and take several minutes.
+* If Si47xx_BUS_STATS is defined in Si4735.h, the bus statistics for the whole
+* run are printed at the end.  See printBusStats() in Si4735.h for the format.
+*/
+
+#include <Si4735.h>
+
+// Note: The Arduino developement software has a design flaw.  If these libraries
+// are not included here, in your application, the Si4735 Library will not be able
+// to find them later.  Also, you should comment out any libraries not needed.
+// Otherwise, they will waste memory.
+//#include "SPI.h"  //SPI class needed by Si4735 Library when using the SPI bus
+#include "Wire.h"  //Wire class needed by Si4735 Library when using the I2C bus
+
+Si4735 radio;
+
+// Mode names for printing
+static const char *mode_name(byte mode){
+  switch(mode){
+    case FM: return "FM";
+    case AM: return "AM";
+    case SW: return "SW";
+    case LW: return "LW";
+  }
+  return "OFF";
+}
+
+// Time one setMode() call and print the result.
+static void bench_set_mode(const char *test, byte mode){
+  #if Si47xx_PROPERTY_CACHE
+  word hits=radio.getPropertyCacheHits();
+  word misses=radio.getPropertyCacheMisses();
+  #endif
+  unsigned long start=micros();
+  radio.setMode(mode);
+  unsigned long elapsed=micros()-start;
+  Serial.print(test);
+  Serial.print(',');
+  Serial.print(mode_name(mode));
+  Serial.print(',');
+  Serial.print(elapsed);
+  #if Si47xx_PROPERTY_CACHE
+  Serial.print(',');
+  Serial.print(radio.getPropertyCacheMisses()-misses);
+  Serial.print(',');
+  Serial.print(radio.getPropertyCacheHits()-hits);
+  #endif
+  Serial.println();
+}
+
+// Scan one band with one strategy and print the result.
+static void bench_scan(const char *test, byte mode, byte strategy){
+  StationRecord stations[32];
+  unsigned long elapsed;
+  radio.setMode(mode);
+  byte count=radio.scanBand(stations, sizeof(stations)/sizeof(stations[0]), strategy, &elapsed);
+  Serial.print(test);
+  Serial.print(',');
+  Serial.print(mode_name(mode));
+  Serial.print(',');
+  Serial.print(elapsed);
+  Serial.print(',');
+  Serial.println(count);
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  radio.begin();
+
+  //Enter each band from low power mode.  This includes POWER_UP.
+  static const byte modes[]={FM, AM, SW, LW};
+  for(byte i=0; i<sizeof(modes); i++){
+    bench_set_mode("setMode_from_off", modes[i]);
+    radio.setMode(RADIO_OFF);
+  }
+  //Switch between AM bands.  The radio stays powered up.
+  radio.setMode(AM);
+  bench_set_mode("setMode_am_band", SW);
+  bench_set_mode("setMode_am_band", LW);
+  bench_set_mode("setMode_am_band", AM);
+  radio.setMode(RADIO_OFF);
+  //Scan each band with each strategy
+  for(byte i=0; i<sizeof(modes); i++){
+    bench_scan("scanBand_seek", modes[i], SCAN_SEEK);
+    bench_scan("scanBand_step", modes[i], SCAN_STEP);
+    bench_scan("scanBand_step_fast", modes[i], SCAN_STEP_FAST);
+  }
+  radio.setMode(RADIO_OFF);
+  #ifdef Si47xx_BUS_STATS
+  radio.printBusStats(&Serial);
+  #endif
+  Serial.println("done");
+}
+
+void loop()
+{
+}
@@ -0,0 +1,65 @@
+/*
+* Si4735 RDS Capture Sketch
+*
+* This sketch records the raw RDS groups sent by an FM station so they can be
+* replayed on a computer.  Use the recordings to test and profile the RDS
+* decoder without a radio.
+*
+* HARDWARE SETUP:
+* This sketch assumes you are using the Si4735 Shield or Breakout Board from
+* SparkFun Electronics with an FM antenna attached.
+*
+* USING THE SKETCH:
+* Uncomment "#define Si47xx_RDS_CAPTURE" in Si4735.h, then set FREQUENCY below
+* to a local station and upload the sketch.  The sketch writes a binary RDS
+* capture stream (see Si47xxCapture.h) to the serial port at 115200 bps.  Do not
+* use the serial monitor.  Save the serial data in a file instead, for example
+* on Linux:
+*    stty -F /dev/ttyACM0 115200 raw
+*    cat /dev/ttyACM0 > station.rds
+* Replay the file on the computer with Si47xxCaptureFile and replayRDS(), or
+* with the RDS benchmark in the library's extras/benchmark folder.
+*/
+
+#include <Si4735.h>
+#include <Si47xxCapture.h>
+
+// Note: The Arduino developement software has a design flaw.  If these libraries
+// are not included here, in your application, the Si4735 Library will not be able
+// to find them later.  Also, you should comment out any libraries not needed.
+// Otherwise, they will waste memory.
+//#include "SPI.h"  //SPI class needed by Si4735 Library when using the SPI bus
+#include "Wire.h"  //Wire class needed by Si4735 Library when using the I2C bus
+
+#ifndef Si47xx_RDS_CAPTURE
+#error Uncomment "#define Si47xx_RDS_CAPTURE" in Si4735.h
+#endif
+
+// Station to record in 10 kHz
+#define FREQUENCY 9730
+
+Si4735 radio;
+
+// Capture sink: send each record to the computer
+void capture(const byte *record){
+  Serial.write(record, RDS_RECORD_LENGTH);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  radio.begin();
+  radio.setMode(FM);
+  radio.tuneFrequencyAndWait(FREQUENCY);
+
+  //Stream header
+  Serial.write((const byte *)RDS_CAPTURE_MAGIC, 3);
+  Serial.write((byte)RDS_CAPTURE_VERSION);
+  radio.setRDSCapture(capture);
+}
+
+void loop()
+{
+  //Every group read is passed to capture()
+  radio.checkRDS();
+}
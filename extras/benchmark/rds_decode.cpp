@@ -0,0 +1,163 @@
+/* Arduino Si4735 Library, RDS decoding benchmark for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Measures how many RDS groups per second the library decodes.  Build and run from the
+ * library's folder:
+ *    g++ -O2 -I. -DSi47xx_RDS_CAPTURE Si4735.cpp RDS.cpp Si47xxBus.cpp Si47xxSim.cpp \
+ *     Si47xxCapture.cpp extras/benchmark/rds_decode.cpp -o rds_decode
+ *    ./rds_decode [file]
+ * An RDS capture file (see Si47xxCapture.h) is decoded with replayRDS(), which measures
+ * the decoder alone.  Other streams are fed through getRDS() by the Si47xxSim radio
+ * simulator (see Si47xxSim.h), 25 groups (one full RDS FIFO) at a time, so the time
+ * includes the library's bus traffic but not the radio's delays.  Without a file, a
+ * built in stream is used.  A text file holds one group per line as four hex blocks,
+ * such as "54A8 0400 E0CD 4B54".  Lines that do not start with four hex blocks are skipped.
+ * Output:
+ *    groups,seconds,groups_per_second,commands_per_group
+ */
+
+#include "Si47xxSim.h"
+#include "Si47xxCapture.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef Si47xx_RDS_CAPTURE
+#error Compile with -DSi47xx_RDS_CAPTURE
+#endif
+
+// Built in stream: a station sending PS, RT, CT, PTYN, and ECC in a typical mix
+static const Si47xxSimGroup stream[]={
+   //0A PS "KTECHNO!"
+   {{0x54A8,0x0400,0xE0CD,0x4B54}}, {{0x54A8,0x0401,0xE0CD,0x4543}},
+   {{0x54A8,0x0402,0xE0CD,0x484E}}, {{0x54A8,0x0403,0xE0CD,0x4F21}},
+   //2A RT "Now playing: Test Tone by Si47xx\r"
+   {{0x54A8,0x2400,0x4E6F,0x7720}}, {{0x54A8,0x2401,0x706C,0x6179}},
+   {{0x54A8,0x2402,0x696E,0x673A}}, {{0x54A8,0x2403,0x2054,0x6573}},
+   {{0x54A8,0x2404,0x7420,0x546F}}, {{0x54A8,0x2405,0x6E65,0x2062}},
+   {{0x54A8,0x2406,0x7920,0x5369}}, {{0x54A8,0x2407,0x3437,0x7878}},
+   {{0x54A8,0x2408,0x0D20,0x2020}},
+   //0B PS, with an error in block C
+   {{0x54A8,0x0800,0x54A8,0x4B54}, RDS_STATUS_RESP12_BLOCK_C_2_BIT_ERRORS},
+   //4A CT
+   {{0x54A8,0x4401,0xD2A6,0x5D42}},
+   //10A PTYN "Techno  "
+   {{0x54A8,0xA400,0x5465,0x6368}}, {{0x54A8,0xA401,0x6E6F,0x2020}},
+   //1A ECC and language
+   {{0x54A8,0x1400,0x00A0,0x0000}}, {{0x54A8,0x1400,0x3009,0x0000}},
+   //3A ODA and 8A TMC, not decoded
+   {{0x54A8,0x3410,0x0000,0xCD46}}, {{0x54A8,0x8400,0x0000,0x0000}},
+   //15B fast basic tuning
+   {{0x54A8,0xF800,0x54A8,0xF800}}
+};
+
+// Total groups decoded
+enum {GROUPS=1000000};
+
+// Decodes capture file with replayRDS().  Returns false if not a capture file.
+static bool replay(const char *path){
+   Si47xxCaptureFile file;
+   if(!file.open(path)) return false;
+   //Load whole file so disk speed is not measured
+   byte *records=0;
+   size_t count=0, size=0;
+   byte record[RDS_RECORD_LENGTH];
+   while(file.read(record)){
+      if(count==size){
+         size = size ? size*2 : 1024;
+         records=(byte *)realloc(records, size*RDS_RECORD_LENGTH);
+      }
+      memcpy(&records[count*RDS_RECORD_LENGTH], record, RDS_RECORD_LENGTH);
+      count++;
+   }
+   if(!count){
+      fprintf(stderr, "No RDS groups in %s\n", path);
+      exit(1);
+   }
+
+   Si4735 radio;
+   unsigned long decoded=0;
+   unsigned long start=micros();
+   while(decoded<GROUPS){
+      for(size_t i=0; i<count; i++) radio.replayRDS(&records[i*RDS_RECORD_LENGTH]);
+      decoded+=count;
+   }
+   unsigned long elapsed=micros()-start;
+
+   double seconds=elapsed/1e6;
+   printf("groups,seconds,groups_per_second,commands_per_group\n");
+   printf("%lu,%.3f,%.0f,0\n", decoded, seconds, decoded/seconds);
+   free(records);
+   return true;
+}
+
+// Reads captured groups from file.  Returns number of groups, or 0 on failure.
+static size_t load(const char *path, Si47xxSimGroup **groups){
+   FILE *file=fopen(path, "r");
+   if(!file) return 0;
+   size_t count=0, size=0;
+   char line[256];
+   while(fgets(line, sizeof(line), file)){
+      unsigned int block[4];
+      if(sscanf(line, "%4x %4x %4x %4x", &block[0], &block[1], &block[2], &block[3])!=4) continue;
+      if(count==size){
+         size = size ? size*2 : 256;
+         *groups=(Si47xxSimGroup *)realloc(*groups, size*sizeof(Si47xxSimGroup));
+      }
+      for(byte i=0; i<4; i++) (*groups)[count].block[i]=block[i];
+      (*groups)[count].errors=0;
+      count++;
+   }
+   fclose(file);
+   return count;
+}
+
+int main(int argc, char *argv[]){
+   const Si47xxSimGroup *groups=stream;
+   size_t count=sizeof(stream)/sizeof(stream[0]);
+   if(argc>1){
+      if(replay(argv[1])) return 0;
+      Si47xxSimGroup *captured=0;
+      count=load(argv[1], &captured);
+      if(!count){
+         fprintf(stderr, "No RDS groups in %s\n", argv[1]);
+         return 1;
+      }
+      groups=captured;
+   }
+
+   Si47xxSim sim;
+   Si4735 radio(&sim);
+   sim.addStation(FM, 9730, 50, 30);
+   radio.begin();
+   radio.setMode(FM);
+   radio.tuneFrequencyAndWait(9730);
+   sim.commands=0;
+
+   unsigned long start=micros();
+   size_t next=0;
+   for(unsigned long n=0; n<GROUPS; n+=SIM_RDS_FIFO_SIZE){
+      for(byte i=0; i<SIM_RDS_FIFO_SIZE; i++){
+         sim.injectRDS(groups[next].block, groups[next].errors);
+         if(++next==count) next=0;
+      }
+      radio.getRDS();
+   }
+   unsigned long elapsed=micros()-start;
+
+   double seconds=elapsed/1e6;
+   printf("groups,seconds,groups_per_second,commands_per_group\n");
+   printf("%lu,%.3f,%.0f,%.2f\n", (unsigned long)sim.rdsReceived, seconds,
+    sim.rdsReceived/seconds, (double)sim.commands/sim.rdsReceived);
+   return 0;
+}
@@ -0,0 +1,106 @@
+/* Arduino Si4735 Library, RDS UTF-8 translation benchmark for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Measures what translating the Radio Text to UTF-8 after every RDS group costs.  Build
+ * and run from the library's folder:
+ *    g++ -O2 -I. -DSi47xx_RDS_CAPTURE -DSi47xx_RDS_UTF8 Si4735.cpp RDS.cpp Si47xxBus.cpp \
+ *     Si47xxSim.cpp extras/benchmark/rds_utf8.cpp -o rds_utf8
+ *    ./rds_utf8
+ * Groups of two Radio Text messages with accented characters are decoded with
+ * replayRDS().  Each test decodes the same groups:
+ *    decode       - Decoding alone
+ *    incremental  - getRadioTextUTF8() after each group
+ *    full         - RDSToUTF8() of the whole Radio Text after each group
+ * Output, with the time spent translating after the cost of decoding is taken out:
+ *    test,groups,ns_per_group,translation_ns_per_group
+ */
+
+#include "Si4735.h"
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(Si47xx_RDS_CAPTURE) || !defined(Si47xx_RDS_UTF8)
+#error Compile with -DSi47xx_RDS_CAPTURE -DSi47xx_RDS_UTF8
+#endif
+
+// Radio Text in RDS character set.  Each message is sent 4 times, then the A/B flag
+// changes.
+static const char *const messages[]={
+   "Tr\x83s c\x82l\x83""bre: \x8B""a va \x81 Z\x99rich, \x82t\x82 \x80 Malm\x97\r",
+   "N\x91""chste Sendung: K\x97ln Caf\x82, Se\x9Aor Espa\x9A""a \xA9""5\r"
+};
+enum {REPEATS=4, GROUPS=2000000};
+
+static byte records[2*REPEATS*16][RDS_RECORD_LENGTH];
+static size_t count;
+
+// Adds 2A groups of message to records.
+static void add_message(const char *text, bool flag){
+   size_t length=strlen(text);
+   for(byte segment=0; segment*4<length && segment<16; segment++){
+      byte *record=records[count++];
+      memset(record, 0, RDS_RECORD_LENGTH);
+      byte *block=&record[RDS_RECORD_BLOCKS];
+      block[0]=0x54;  block[1]=0xA8;                      //PI
+      block[2]=0x24;  block[3]=(flag ? 0x10 : 0) | segment;  //2A, A/B flag
+      for(byte i=0; i<4; i++){
+         size_t position=segment*4+i;
+         block[4+i] = position<length ? text[position] : ' ';
+      }
+      record[RDS_RECORD_FLAGS]=RDS_RECORD_SYNC;
+   }
+}
+
+enum {DECODE, INCREMENTAL, FULL};
+
+// Returns ns per group for the test
+static double run(byte test){
+   Si4735 radio;
+   char utf8[RDS_RT_UTF8_SIZE];
+   unsigned long bytes=0;  //Keeps translation from being optimized away
+   unsigned long start=micros();
+   for(unsigned long n=0; n<GROUPS; n+=count){
+      for(size_t i=0; i<count; i++){
+         radio.replayRDS(records[i]);
+         if(test==INCREMENTAL){
+            if(radio.getRadioTextUTF8(utf8, sizeof(utf8))) bytes+=utf8[0];
+         }else if(test==FULL){
+            bytes+=Si4735::RDSToUTF8(utf8, sizeof(utf8), radio.rds.radioText,
+             radio.rds.radioTextLen);
+         }
+      }
+   }
+   unsigned long elapsed=micros()-start;
+   if(test==INCREMENTAL){
+      radio.getRadioTextUTF8(utf8, sizeof(utf8));
+      fprintf(stderr, "%s\n", utf8);
+   }
+   if(bytes==1) fprintf(stderr, "\n");
+   return elapsed*1000.0/GROUPS;
+}
+
+int main(){
+   for(byte m=0; m<2; m++){
+      for(byte r=0; r<REPEATS; r++) add_message(messages[m], m);
+   }
+   static const char *const names[]={"decode", "incremental", "full"};
+   double decode=run(DECODE);
+   printf("test,groups,ns_per_group,translation_ns_per_group\n");
+   printf("%s,%lu,%.1f,0.0\n", names[DECODE], (unsigned long)GROUPS, decode);
+   for(byte test=INCREMENTAL; test<=FULL; test++){
+      double ns=run(test);
+      printf("%s,%lu,%.1f,%.1f\n", names[test], (unsigned long)GROUPS, ns, ns-decode);
+   }
+   return 0;
+}
@@ -0,0 +1,43 @@
+#!/bin/sh
+# Arduino Si4735 Library, benchmark runner for host computers.
+#
+# Builds the library and extras/benchmark/suite.cpp, then prints the code size of each
+# library file and the suite's results as comma separated lines:
+#    size,file,text,data,bss
+#    test,case,count,ns_each,bus_bytes_each,commands_each,radio_us_each
+#    spi,case,calls,transfers,sizes
+# Run from anywhere.  Compiler flags given as arguments are added to every compile, to
+# measure compile time options:
+#    extras/benchmark/run.sh -DSi47xx_SPI -DSi47xx_BUS_STATS=16 > results.csv
+# The suite's cts test is also built with -DSi47xx_CTS_DELAY and its lines added, to
+# compare polling for CTS with fixed delays.
+# Save the output for each commit and compare with diff.  Code size is measured with the
+# host's compiler (CXX, default g++) at -Os.  It is not the size on an Arduino, but it
+# changes when the library's code does.
+
+set -e
+cd "$(dirname "$0")/../.."
+CXX=${CXX:-g++}
+SIZE=${SIZE:-size}
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+echo "size,file,text,data,bss"
+for file in Si4735.cpp RDS.cpp Si47xxBus.cpp; do
+   $CXX -Os -I. "$@" -c $file -o "$out/${file%.cpp}.o"
+   $SIZE "$out/${file%.cpp}.o" | awk -v file=$file 'NR==2 {print "size," file "," $1 "," $2 "," $3}'
+done
+
+$CXX -O2 -I. "$@" Si4735.cpp RDS.cpp Si47xxBus.cpp Si47xxSim.cpp \
+ extras/benchmark/suite.cpp -o "$out/suite"
+"$out/suite"
+
+# cts test again with fixed CTS delays, unless the flags already select them
+case " $* " in
+*" -DSi47xx_CTS_DELAY "*) ;;
+*)
+   $CXX -O2 -I. "$@" -DSi47xx_CTS_DELAY Si4735.cpp RDS.cpp Si47xxBus.cpp Si47xxSim.cpp \
+    extras/benchmark/suite.cpp -o "$out/suite_delay"
+   "$out/suite_delay" | grep '^cts,'
+   ;;
+esac
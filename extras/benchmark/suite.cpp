@@ -0,0 +1,307 @@
+/* Arduino Si4735 Library, benchmark suite for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Times the library's command path, RDS decoding, and string methods against the
+ * Si47xxSim radio simulator (see Si47xxSim.h).  Build and run from the library's folder:
+ *    g++ -O2 -I. Si4735.cpp RDS.cpp Si47xxBus.cpp Si47xxSim.cpp \
+ *     extras/benchmark/suite.cpp -o suite
+ *    ./suite
+ * or run extras/benchmark/run.sh, which also reports code size.  Tests:
+ *    setMode           - setMode() from RADIO_OFF into each band, including POWER_UP
+ *    getRDS            - getRDS() reading and decoding a full RDS FIFO of 25 groups
+ *    getCallSign       - Call sign from an RBDS PI code
+ *    getProgramTypeStr - Program type name for each PTY code
+ *    getLocalDateTime  - Local date and time from a CT group
+ *    framing           - Bus traffic of single calls when the radio sets CTS at once, so
+ *                        only command and response framing is counted.  For SPI the bus
+ *                        runs at 250 kHz, the default RADIO_SPI_CLOCK_DIV on a 16 MHz AVR.
+ *    cts               - Single commands with the simulator's typical CTS times.  Cases
+ *                        start with "poll_", or "delay_" when built with Si47xx_CTS_DELAY.
+ *                        run.sh adds the delay_ lines from a second build for comparison.
+ *    spi               - Calls to the SPI hardware made by Si47xxSPIBus for the same library
+ *                        calls, moving each transaction in one block or byte by byte.
+ *                        Uses Si47xxSPIMock instead of the simulator.
+ * Output is one comma separated line per test, so results from two builds can be
+ * compared with diff or a spreadsheet:
+ *    test,case,count,ns_each,bus_bytes_each,commands_each,radio_us_each
+ * ns_each is host time.  Bus bytes include bus overhead, such as I2C addresses.
+ * radio_us_each is time on the simulator's clock, which includes the radio's delays
+ * and the time to move bytes across a real SPI or I2C bus.  Columns that do not apply
+ * to a test are 0.  The spi test prints its own lines:
+ *    spi,case,calls,transfers,sizes
+ * transfers is the number of calls to the SPI hardware.  sizes lists bytes:transfers for
+ * each transfer size used, separated by spaces.
+ */
+
+#include "Si47xxSim.h"
+#include <stdio.h>
+
+#ifdef Si47xx_AM_ONLY
+#error The suite needs FM and RDS.  Compile without -DSi47xx_AM_ONLY
+#endif
+
+// Repetitions of each test
+enum {
+   SET_MODE_COUNT=200,
+   RDS_GROUPS=1000000,
+   STRING_COUNT=1000000,
+   FRAMING_COUNT=1000,
+   CTS_COUNT=1000,
+   SPI_COUNT=100
+};
+
+// RDS stream for getRDS(): PS, RT, CT, PTYN, and ECC in a typical mix
+static const Si47xxSimGroup stream[]={
+   //0A PS "KTECHNO!"
+   {{0x54A8,0x0400,0xE0CD,0x4B54}}, {{0x54A8,0x0401,0xE0CD,0x4543}},
+   {{0x54A8,0x0402,0xE0CD,0x484E}}, {{0x54A8,0x0403,0xE0CD,0x4F21}},
+   //2A RT "Now playing: Test Tone by Si47xx\r"
+   {{0x54A8,0x2400,0x4E6F,0x7720}}, {{0x54A8,0x2401,0x706C,0x6179}},
+   {{0x54A8,0x2402,0x696E,0x673A}}, {{0x54A8,0x2403,0x2054,0x6573}},
+   {{0x54A8,0x2404,0x7420,0x546F}}, {{0x54A8,0x2405,0x6E65,0x2062}},
+   {{0x54A8,0x2406,0x7920,0x5369}}, {{0x54A8,0x2407,0x3437,0x7878}},
+   {{0x54A8,0x2408,0x0D20,0x2020}},
+   //0B PS, with an error in block C
+   {{0x54A8,0x0800,0x54A8,0x4B54}, RDS_STATUS_RESP12_BLOCK_C_2_BIT_ERRORS},
+   //4A CT
+   {{0x54A8,0x4401,0xD2A6,0x5D42}},
+   //10A PTYN "Techno  "
+   {{0x54A8,0xA400,0x5465,0x6368}}, {{0x54A8,0xA401,0x6E6F,0x2020}},
+   //1A ECC and language
+   {{0x54A8,0x1400,0x00A0,0x0000}}, {{0x54A8,0x1400,0x3009,0x0000}},
+   //3A ODA and 8A TMC
+   {{0x54A8,0x3410,0x0000,0xCD46}}, {{0x54A8,0x8400,0x0000,0x0000}},
+   //15B fast basic tuning
+   {{0x54A8,0xF800,0x54A8,0xF800}}
+};
+enum {STREAM_LENGTH=sizeof(stream)/sizeof(stream[0])};
+
+// Sink for results the compiler must not optimize away
+static volatile unsigned long sink;
+
+// Simulator counters at start of a test
+static unsigned long bus_bytes, commands, radio_time;
+
+static void start(Si47xxSim *sim){
+   bus_bytes=sim->bytesWritten+sim->bytesRead;
+   commands=sim->commands;
+   radio_time=sim->now();
+}
+
+static void result(const char *test, const char *name, unsigned long count, unsigned long us,
+ Si47xxSim *sim){
+   double bytes=0, sent=0, radio_us=0;
+   if(sim){
+      bytes=(double)(sim->bytesWritten+sim->bytesRead-bus_bytes)/count;
+      sent=(double)(sim->commands-commands)/count;
+      radio_us=(double)(sim->now()-radio_time)/count;
+   }
+   printf("%s,%s,%lu,%.1f,%.1f,%.2f,%.1f\n", test, name, count, us*1000.0/count,
+    bytes, sent, radio_us);
+}
+
+// setMode() from RADIO_OFF into each band.  The time to turn the radio off is not counted.
+static void bench_set_mode(){
+   static const byte modes[]={FM, AM, SW, LW};
+   static const char *const names[]={"FM", "AM", "SW", "LW"};
+   for(byte m=0; m<sizeof(modes); m++){
+      Si47xxSim sim;
+      Si4735 radio(&sim);
+      radio.begin();
+      unsigned long us=0;
+      unsigned long bytes=0, sent=0, radio_us=0;
+      for(word i=0; i<SET_MODE_COUNT; i++){
+         start(&sim);
+         unsigned long begin=micros();
+         radio.setMode(modes[m]);
+         us+=micros()-begin;
+         bytes+=sim.bytesWritten+sim.bytesRead-bus_bytes;
+         sent+=sim.commands-commands;
+         radio_us+=sim.now()-radio_time;
+         radio.setMode(RADIO_OFF);
+      }
+      //Report totals of the timed calls only
+      printf("setMode,%s,%u,%.1f,%.1f,%.2f,%.1f\n", names[m], SET_MODE_COUNT,
+       us*1000.0/SET_MODE_COUNT, (double)bytes/SET_MODE_COUNT, (double)sent/SET_MODE_COUNT,
+       (double)radio_us/SET_MODE_COUNT);
+   }
+}
+
+// getRDS() with the radio's RDS FIFO full each time
+static void bench_get_rds(Si47xxSim *sim, Si4735 *radio){
+   byte next=0;
+   unsigned long groups=0;
+   start(sim);
+   unsigned long begin=micros();
+   while(groups<RDS_GROUPS){
+      for(byte i=0; i<SIM_RDS_FIFO_SIZE; i++){
+         sim->injectRDS(stream[next].block, stream[next].errors);
+         if(++next==STREAM_LENGTH) next=0;
+      }
+      radio->getRDS();
+      groups+=SIM_RDS_FIFO_SIZE;
+   }
+   result("getRDS", "group", groups, micros()-begin, sim);
+}
+
+static void bench_call_sign(Si4735 *radio){
+   char call_sign[5];
+   unsigned long begin=micros();
+   for(unsigned long i=0; i<STRING_COUNT; i++){
+      //PI codes of 4 letter US call signs
+      radio->rds.programId=0x1000+(i&0x7FFF);
+      sink+=radio->getCallSign(call_sign);
+   }
+   result("getCallSign", "rbds", STRING_COUNT, micros()-begin, 0);
+}
+
+static void bench_program_type(Si4735 *radio){
+   char text[17];
+   static const char *const names[]={"rds", "rbds"};
+   for(byte rbds=0; rbds<2; rbds++){
+      radio->rds.RBDS=rbds;
+      unsigned long begin=micros();
+      for(unsigned long i=0; i<STRING_COUNT; i++){
+         radio->rds.programType=i&31;
+         radio->getProgramTypeStr(text);
+         sink+=text[0];
+      }
+      result("getProgramTypeStr", names[rbds], STRING_COUNT, micros()-begin, 0);
+   }
+}
+
+static void bench_date_time(Si4735 *radio){
+   DateTime date_time;
+   unsigned long begin=micros();
+   for(unsigned long i=0; i<STRING_COUNT; i++){
+      //Walk the time zone offset through -12 to +12 hours
+      radio->rds.offset=(signed char)(i%49)-24;
+      radio->getLocalDateTime(&date_time);
+      sink+=date_time.day;
+   }
+   result("getLocalDateTime", "offset", STRING_COUNT, micros()-begin, 0);
+}
+
+// Single calls with no CTS polling
+static void bench_framing(){
+   Si47xxSim sim;
+   Si4735 radio(&sim);
+   sim.addStation(FM, 9730, 50, 30);
+   radio.begin();
+   radio.setMode(FM);
+   radio.tuneFrequencyAndWait(9730);
+   sim.clearCommandTimes();
+   sim.timing.cts=0;
+ #ifdef Si47xx_SPI
+   sim.setBusSpeed(250000);
+ #endif
+   RSQMetrics RSQ;
+   start(&sim);
+   unsigned long begin=micros();
+   for(word i=0; i<FRAMING_COUNT; i++) radio.getRSQ(&RSQ);
+   result("framing", "getRSQ", FRAMING_COUNT, micros()-begin, &sim);
+   start(&sim);
+   begin=micros();
+   for(word i=0; i<FRAMING_COUNT; i++) sink+=radio.getFrequency();
+   result("framing", "getFrequency", FRAMING_COUNT, micros()-begin, &sim);
+   start(&sim);
+   begin=micros();
+   for(word i=0; i<FRAMING_COUNT; i++){
+      sim.injectRDS(stream[0].block);
+      radio.getRDS();
+   }
+   result("framing", "getRDS", FRAMING_COUNT, micros()-begin, &sim);
+}
+
+// Single commands waiting for CTS by polling, or by fixed delays with Si47xx_CTS_DELAY
+static void bench_cts(){
+ #ifdef Si47xx_CTS_DELAY
+   #define CTS_CASE(name) "delay_" name
+ #else
+   #define CTS_CASE(name) "poll_" name
+ #endif
+   Si47xxSim sim;
+   Si4735 radio(&sim);
+   sim.addStation(FM, 9730, 50, 30);
+   radio.begin();
+   radio.setMode(FM);
+   radio.tuneFrequencyAndWait(9730);
+   static const byte GET_REV[]={CMD_GET_REV};
+   start(&sim);
+   unsigned long begin=micros();
+   for(word i=0; i<CTS_COUNT; i++) radio.sendCommand(GET_REV, sizeof(GET_REV));
+   result("cts", CTS_CASE("GET_REV"), CTS_COUNT, micros()-begin, &sim);
+   start(&sim);
+   begin=micros();
+   //Change the value each time so the property cache does not skip the command
+   for(word i=0; i<CTS_COUNT; i++) radio.setVolume(i&1 ? 40 : 50);
+   result("cts", CTS_CASE("SET_PROPERTY"), CTS_COUNT, micros()-begin, &sim);
+   RSQMetrics RSQ;
+   start(&sim);
+   begin=micros();
+   for(word i=0; i<CTS_COUNT; i++) radio.getRSQ(&RSQ);
+   result("cts", CTS_CASE("FM_RSQ_STATUS"), CTS_COUNT, micros()-begin, &sim);
+   #undef CTS_CASE
+}
+
+// SPI hardware calls for the same library calls, in blocks and byte by byte
+static void bench_spi(){
+   static const char *const names[]={"bytes", "block"};
+   for(byte block=0; block<2; block++){
+      Si47xxSPIMock bus;
+      Si4735 radio(&bus);
+      bus.blockTransfers=block;
+      radio.begin();
+      radio.setMode(FM);
+      bus.clearTransfers();
+      static const byte GET_REV[]={CMD_GET_REV};
+      RSQMetrics RSQ;
+      for(word i=0; i<SPI_COUNT; i++){
+         radio.sendCommand(GET_REV, sizeof(GET_REV));
+         radio.setVolume(i&1 ? 40 : 50);
+         radio.getRSQ(&RSQ);
+         radio.getRDS();
+      }
+      printf("spi,%s,%u,%lu,", names[block], SPI_COUNT*4, bus.transfers);
+      const char *separator="";
+      for(byte size=0; size<=SPI_FRAME_MAX; size++){
+         if(!bus.transferSizes[size]) continue;
+         printf("%s%u:%lu", separator, size, bus.transferSizes[size]);
+         separator=" ";
+      }
+      printf("\n");
+   }
+}
+
+int main(){
+   printf("test,case,count,ns_each,bus_bytes_each,commands_each,radio_us_each\n");
+   bench_set_mode();
+
+   //Radio tuned to an FM station for the RDS tests
+   Si47xxSim sim;
+   Si4735 radio(&sim);
+   sim.addStation(FM, 9730, 50, 30);
+   radio.begin();
+   radio.setMode(FM);
+   radio.tuneFrequencyAndWait(9730);
+   bench_get_rds(&sim, &radio);
+   //String tests use the station info left by the RDS test, including its CT group
+   bench_call_sign(&radio);
+   bench_program_type(&radio);
+   bench_date_time(&radio);
+   bench_framing();
+   bench_cts();
+   bench_spi();
+   return 0;
+}
@@ -0,0 +1,64 @@
+/* Arduino Si4735 Library, RDS capture replay for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Decodes an RDS capture file (see Si47xxCapture.h) with replayRDS() and prints a line
+ * each time the decoded station info changes.  Compare the output of two library
+ * versions to find decoder regressions.  Build and run from the library's folder:
+ *    g++ -O2 -I. -DSi47xx_RDS_CAPTURE Si4735.cpp RDS.cpp Si47xxBus.cpp \
+ *     Si47xxCapture.cpp extras/replay/rds_replay.cpp -o rds_replay
+ *    ./rds_replay station.rds
+ * Output:
+ *    milliseconds,PI,PTY,TP,TA,PS,PTYN,RT
+ * milliseconds is the capture time of the group that caused the change.
+ */
+
+#include "Si47xxCapture.h"
+#include <stdio.h>
+
+#ifndef Si47xx_RDS_CAPTURE
+#error Compile with -DSi47xx_RDS_CAPTURE
+#endif
+
+int main(int argc, char *argv[]){
+   if(argc!=2){
+      fprintf(stderr, "Usage: %s file\n", argv[0]);
+      return 2;
+   }
+   Si47xxCaptureFile file;
+   if(!file.open(argv[1])){
+      fprintf(stderr, "%s is not an RDS capture file\n", argv[1]);
+      return 1;
+   }
+
+   Si4735 radio;
+   byte record[RDS_RECORD_LENGTH];
+   char line[256], last[256]="";
+   unsigned long groups=0;
+   printf("milliseconds,PI,PTY,TP,TA,PS,PTYN,RT\n");
+   while(file.read(record)){
+      groups++;
+      if(!radio.replayRDS(record)) continue;
+      snprintf(line, sizeof(line), "%04X,%u,%d,%d,\"%s\",\"%s\",\"%.*s\"",
+       radio.rds.programId, radio.rds.programType, radio.rds.trafficProgram,
+       radio.rds.trafficAlert, radio.rds.programService, radio.rds.programTypeName,
+       (int)radio.rds.radioTextLen, radio.rds.radioText);
+      if(strcmp(line, last)==0) continue;
+      strcpy(last, line);
+      unsigned long time=0;
+      for(byte i=4; i>0; i--) time = time<<8 | record[RDS_RECORD_TIME+i-1];
+      printf("%lu,%s\n", time, line);
+   }
+   fprintf(stderr, "%lu groups\n", groups);
+   return 0;
+}
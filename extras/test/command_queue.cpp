@@ -0,0 +1,134 @@
+/* Arduino Si4735 Library, command queue test for host computers.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * To view a copy of the GNU Lesser General Public License, visit these two web pages:
+ *    http://www.gnu.org/licenses/gpl-3.0.html
+ *    http://www.gnu.org/licenses/lgpl-3.0.html
+ *
+ * See README and Si4735.h files for additional documentation.
+ *
+ * Drives the non-blocking command queue (queueCommand(), queueProperty(), poll(), and
+ * flushCommands()) against the Si47xxSim radio simulator (see Si47xxSim.h).  Build and
+ * run from the library's folder:
+ *    g++ -O2 -I. -DSi47xx_COMMAND_QUEUE=4 Si4735.cpp RDS.cpp Si47xxBus.cpp \
+ *     Si47xxSim.cpp extras/test/command_queue.cpp -o command_queue
+ *    ./command_queue
+ * Checks:
+ *    order        - Callbacks run in queue order with the radio's response bytes
+ *    transactions - Each poll() makes exactly one bus transaction
+ *    mixed        - Blocking calls finish queued commands first and see their effects
+ * Prints one line per check, PASS or FAIL, and returns 1 if any check failed.
+ */
+
+#include "Si47xxSim.h"
+#include <stdio.h>
+
+#ifndef Si47xx_COMMAND_QUEUE
+#error Compile with -DSi47xx_COMMAND_QUEUE=4
+#endif
+
+// Callbacks log which command finished and keep its response
+enum {LOG_SIZE=8};
+static byte log_id[LOG_SIZE];
+static byte log_result[LOG_SIZE];
+static byte log_response[LOG_SIZE][RESP_MAX_LENGTH];
+static byte log_length[LOG_SIZE];
+static byte log_count;
+
+static void log_command(byte id, byte result, const byte *response, byte length){
+   if(log_count>=LOG_SIZE) return;
+   log_id[log_count]=id;
+   log_result[log_count]=result;
+   memcpy(log_response[log_count], response, length);
+   log_length[log_count]=length;
+   log_count++;
+}
+
+static void on_rev(byte result, const byte *response, byte length){
+   log_command(1, result, response, length);
+}
+
+static void on_set(byte result, const byte *response, byte length){
+   log_command(2, result, response, length);
+}
+
+static void on_get(byte result, const byte *response, byte length){
+   log_command(3, result, response, length);
+}
+
+static int failures;
+
+static void check(const char *name, bool passed){
+   printf("%s,%s\n", name, passed ? "PASS" : "FAIL");
+   if(!passed) failures++;
+}
+
+// Bus transactions made so far
+static unsigned long transactions(Si47xxSim *sim){
+   return sim->commands+sim->statusReads+sim->responseReads;
+}
+
+// Queues GET_PROPERTY for the given property
+static bool queue_get_property(Si4735 *radio, word property, CommandCallback callback){
+   byte command[4]={CMD_GET_PROPERTY, 0, (byte)(property>>8), (byte)property};
+   return radio->queueCommand(command, sizeof(command), 4, callback);
+}
+
+int main(){
+   Si47xxSim sim;
+   Si4735 radio(&sim);
+   sim.addStation(FM, 9730, 50, 30);
+   radio.begin();
+   radio.setMode(FM);
+
+   //Three commands with different responses, finished one bus transaction at a time
+   static const byte GET_REV[]={CMD_GET_REV};
+   log_count=0;
+   bool queued = radio.queueCommand(GET_REV, sizeof(GET_REV), 9, on_rev) &&
+    radio.queueProperty(PROP_RX_VOLUME, 40, on_set) &&
+    queue_get_property(&radio, PROP_RX_VOLUME, on_get);
+   bool single=true;
+   word polls=0;
+   for(;;){
+      unsigned long before=transactions(&sim);
+      bool more=radio.poll();
+      if(transactions(&sim)-before!=1) single=false;
+      polls++;
+      if(!more) break;
+   }
+   check("order", queued && log_count==3 &&
+    log_id[0]==1 && log_id[1]==2 && log_id[2]==3 &&
+    log_result[0]==RADIO_OK && log_result[1]==RADIO_OK && log_result[2]==RADIO_OK &&
+    //GET_REV: part number and chip revision
+    log_length[0]==9 && log_response[0][1]==35 && log_response[0][8]=='D' &&
+    //SET_PROPERTY has no response
+    log_length[1]==0 &&
+    //GET_PROPERTY sees the value set before it
+    log_length[2]==4 && MAKE_WORD(log_response[2][2], log_response[2][3])==40);
+   //Each command is sent by one poll() and finished by at least one more
+   check("transactions", single && polls>=6 && radio.queuedCommands()==0);
+
+   //Blocking calls between queued commands
+   log_count=0;
+   queued = queue_get_property(&radio, PROP_RX_VOLUME, on_get) &&
+    radio.queueProperty(PROP_RX_VOLUME, 20, on_set);
+   //Send first queued command, but do not wait for it
+   radio.poll();
+   //getProperty() must finish both queued commands before asking the radio
+   word volume=radio.getProperty(PROP_RX_VOLUME);
+   bool flushed = log_count==2 && radio.queuedCommands()==0;
+   //Queue again after a blocking command
+   queued = queued && queue_get_property(&radio, PROP_RX_VOLUME, on_get);
+   radio.flushCommands();
+   check("mixed", queued && flushed && volume==20 && sim.getProperty(PROP_RX_VOLUME)==20 &&
+    log_count==3 && log_id[0]==3 && log_id[1]==2 && log_id[2]==3 &&
+    MAKE_WORD(log_response[0][2], log_response[0][3])==40 &&
+    MAKE_WORD(log_response[2][2], log_response[2][3])==20);
+
+   return failures ? 1 : 0;
+}